@@ -47,11 +47,34 @@ int main(int argc, char *argv[]) {
 Application::Application(char *infile) {
 	int i;
 	par = new Params();
-	srand (time(NULL));
 	par->setparams(infile);
+	srand (par->SEED ? par->SEED : time(NULL));
 	log = new Log(par);
-	en = new EmulNet(par);
-	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
+	runPid = getpid();
+	if ( par->PROCESS_PER_NODE && par->TRANSPORT == EMUL_TRANSPORT ) {
+		cout<<"PROCESS_PER_NODE needs TRANSPORT: UDP or SHM, running all nodes in this process"<<endl;
+		par->PROCESS_PER_NODE = 0;
+	}
+	// no worker threads when the process is going to fork
+	exec = new Executor(par->PROCESS_PER_NODE ? 1 : par->THREADS);
+	mp1.resize(par->EN_GPSZ, NULL);
+	loopAt.assign(par->EN_GPSZ, -1);
+
+	if ( par->PROCESS_PER_NODE ) {
+		/*
+		 * Every node is set up by its own process, see runNode; this one only
+		 * opens the logs, which the node processes share
+		 */
+		en = NULL;
+		for( i = 0; i < par->EN_GPSZ; i++ ) {
+			Address addressOfMemberNode;
+			addressOfMemberNode.init();
+			*(int *)(&addressOfMemberNode.addr) = i + 1;
+			log->LOG(&addressOfMemberNode, "APP");
+		}
+		return;
+	}
+	en = newNet();
 
 	/*
 	 * Init all nodes
@@ -67,21 +90,46 @@ Application::Application(char *infile) {
 		log->LOG(&(mp1[i]->getMemberNode()->addr), "APP");
 		delete addressOfMemberNode;
 	}
+
+	/*
+	 * Node i is introduced at STEP_RATE * i, failures are scripted at fixed ticks
+	 */
+	for( i = 0; i < par->EN_GPSZ; i++ ) {
+		schedule((int)(par->STEP_RATE*i), i, NODE_START);
+	}
+	schedule(50, -1, APP_WAKEUP);
+	schedule(100, -1, APP_WAKEUP);
+	schedule(300, -1, APP_WAKEUP);
 }
 
 /**
  * Destructor
  */
 Application::~Application() {
+	delete exec;
 	delete log;
 	delete en;
 	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
 		delete mp1[i];
 	}
-	free(mp1);
 	delete par;
 }
 
+/**
+ * FUNCTION NAME: newNet
+ *
+ * DESCRIPTION: Network of the TRANSPORT the test case asks for
+ */
+EmulNet *Application::newNet() {
+	if ( par->TRANSPORT == UDP_TRANSPORT ) {
+		return new UdpNet(par, par->PORTNUM);
+	}
+	else if ( par->TRANSPORT == SHM_TRANSPORT ) {
+		return new ShmNet(par, par->PORTNUM, runPid);
+	}
+	return new EmulNet(par);
+}
+
 /**
  * FUNCTION NAME: run
  *
@@ -93,10 +141,14 @@ int Application::run()
 	int timeWhenAllNodesHaveJoined = 0;
 	// boolean indicating if all nodes have joined
 	bool allNodesJoined = false;
-	srand(time(NULL));
+	srand(par->SEED ? par->SEED : time(NULL));
+
+	if ( par->PROCESS_PER_NODE ) {
+		return runProcesses();
+	}
 
-	// As time runs along
-	for( par->globaltime = 0; par->globaltime < TOTAL_RUNNING_TIME; ++par->globaltime ) {
+	// As time runs along, skipping ticks in which nothing is due
+	for( par->globaltime = 0; par->globaltime < par->TOTAL_RUNNING_TIME; par->globaltime = nextTime() ) {
 		// Run the membership protocol
 		mp1Run();
 		// Fail some nodes
@@ -106,6 +158,11 @@ int Application::run()
 	// Clean up
 	en->ENcleanup();
 
+	// How balanced the per-node phases were
+	FILE *file = fopen(EXECSTATS_LOG, "w+");
+	exec->printStats(file);
+	fclose(file);
+
 	for(i=0;i<=par->EN_GPSZ-1;i++) {
 		 mp1[i]->finishUpThisNode();
 	}
@@ -113,44 +170,224 @@ int Application::run()
 	return SUCCESS;
 }
 
+/**
+ * FUNCTION NAME: runProcesses
+ *
+ * DESCRIPTION: Fork one process per node, wait for all of them and write their
+ * 				CPU time and memory to netstats.log. Tick 0 starts at the same
+ * 				wall-clock time in every process.
+ */
+int Application::runProcesses() {
+	long long start = EmulNet::ENclock() + PROCESS_START_USEC;
+	vector<pid_t> pids;
+	int i, status, crashed = 0;
+	struct rusage usage;
+	double user = 0, sys = 0;
+	long maxrss = 0;
+
+	// every process has to agree on who fails
+	pickFailures();
+	// nothing buffered may be written twice
+	fflush(NULL);
+
+	for( i = 0; i < par->EN_GPSZ; i++ ) {
+		pid_t pid = fork();
+		if ( pid < 0 ) {
+			perror("fork");
+			break;
+		}
+		if ( pid == 0 ) {
+			runNode(i, start);
+			fflush(NULL);
+			_exit(SUCCESS);
+		}
+		pids.push_back(pid);
+	}
+
+	for( i = 0; i < (int)pids.size(); i++ ) {
+		if ( wait4(pids[i], &status, 0, &usage) < 0 ) {
+			crashed++;
+			continue;
+		}
+		if ( !WIFEXITED(status) || WEXITSTATUS(status) != SUCCESS ) {
+			crashed++;
+		}
+		user += usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+		sys += usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+		maxrss = max(maxrss, usage.ru_maxrss);
+	}
+
+	FILE *file = fopen(NETSTATS_LOG, "w+");
+	fprintf(file, "processes %d crashed %d ticks %d tick_usec %d\n", (int)pids.size(), crashed, par->TOTAL_RUNNING_TIME, par->TICK_USEC);
+	fprintf(file, "cpu user_sec %.3f sys_sec %.3f per_tick_usec %.1f max_rss_kb %ld\n", user, sys, par->TOTAL_RUNNING_TIME > 0 ? (user + sys) * 1e6 / par->TOTAL_RUNNING_TIME : 0.0, maxrss);
+	fprintf(file, "per node stats in " NODE_DIR "/<id>/\n");
+	fclose(file);
+
+	return crashed ? FAILURE : SUCCESS;
+}
+
+/**
+ * FUNCTION NAME: runNode
+ *
+ * DESCRIPTION: Body of the process of node i: set up its network and the node,
+ * 				then run it tick by tick, a tick every TICK_USEC of wall-clock
+ * 				time from start. Between ticks the process sleeps in ENwait,
+ * 				where the messages of its peers come in.
+ */
+void Application::runNode(int i, long long start) {
+	int startTick = (int)(par->STEP_RATE*i);
+	int late = 0;
+	long long lag, maxLag = 0;
+	char dir[64];
+
+	// every process inherited the same random state; give each its own for the
+	// message drops and the node's gossip targets
+	srand(rand() + i);
+	en = newNet();
+	en->ENsolo(i + 1);
+	Member *memberNode = new Member;
+	memberNode->inited = false;
+	Address *addressOfMemberNode = new Address();
+	addressOfMemberNode = (Address *) en->ENinit(addressOfMemberNode, par->PORTNUM);
+	mp1[i] = new MP1Node(memberNode, par, en, log, addressOfMemberNode);
+	delete addressOfMemberNode;
+	Address *addr = &mp1[i]->getMemberNode()->addr;
+
+	for( par->globaltime = 0; par->globaltime < par->TOTAL_RUNNING_TIME; par->globaltime++ ) {
+		long long deadline = start + (long long)par->globaltime * par->TICK_USEC;
+		en->ENwait(addr, deadline);
+		lag = EmulNet::ENclock() - deadline;
+		if ( lag > par->TICK_USEC ) {
+			// the last tick took longer than a tick
+			late++;
+		}
+		maxLag = max(maxLag, lag);
+
+		// Same order as mp1Run: receive, then start or loop, then failures
+		if( par->getcurrtime() > startTick ) {
+			mp1[i]->recvLoop();
+		}
+		if( par->getcurrtime() == startTick ) {
+			mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
+			cout<<i<<"-th introduced node is assigned with the address: "<<addr->getAddress() << endl;
+		}
+		else if( par->getcurrtime() > startTick ) {
+			mp1[i]->nodeLoop();
+		}
+		fail();
+	}
+
+	// The stats files of this node go to a directory of its own
+	mkdir(NODE_DIR, 0755);
+	sprintf(dir, NODE_DIR "/%d", i + 1);
+	mkdir(dir, 0755);
+	if ( chdir(dir) < 0 ) {
+		perror("chdir");
+		return;
+	}
+	en->ENcleanup();
+	FILE *file = fopen(NETSTATS_LOG, "a");
+	if ( file ) {
+		fprintf(file, "process ticks %d late %d max_lag_usec %lld\n", par->TOTAL_RUNNING_TIME, late, maxLag);
+		fclose(file);
+	}
+	mp1[i]->finishUpThisNode();
+	// the process leaves with _exit, give back the sockets or rings of the node here
+	delete mp1[i];
+	mp1[i] = NULL;
+	delete en;
+	en = NULL;
+}
+
 /**
  * FUNCTION NAME: mp1Run
  *
  * DESCRIPTION:	This function performs all the membership protocol functionalities
  */
 void Application::mp1Run() {
+	unsigned int k;
 	int i;
+	vector<int> ready;
+	vector<int> receivers;
+	vector<app_event> due;
+	vector<app_event> nodes;
 
-	// For all the nodes in the system
-	for( i = 0; i <= par->EN_GPSZ-1; i++) {
+	/*
+	 * Only the nodes the network has delivered messages to have anything to receive
+	 */
+	en->ENready(ready);
+	ready.insert(ready.end(), held.begin(), held.end());
+	held.clear();
+	for( k = 0; k < ready.size(); k++ ) {
+		i = ready[k] - 1;
+		if( i < 0 || i >= par->EN_GPSZ || mp1[i]->getMemberNode()->bFailed ) {
+			continue;
+		}
+		if( par->getcurrtime() > (int)(par->STEP_RATE*i) ) {
+			receivers.push_back(i);
+		}
+		else {
+			held.push_back(ready[k]);
+		}
+	}
+	sort(receivers.begin(), receivers.end());
+	receivers.erase(unique(receivers.begin(), receivers.end()), receivers.end());
+
+	// For the nodes with messages, in node order
+	runPhase(receivers.size(), [&](int task) {
 
 		/*
 		 * Receive messages from the network and queue them in the membership protocol queue
 		 */
-		if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
-			// Receive messages from the network and queue them
-			mp1[i]->recvLoop();
-		}
+		mp1[receivers[task]]->recvLoop();
 
+	});
+
+	/*
+	 * Only the nodes with messages, or with a start or a loop due now, have work to do
+	 */
+	for( k = 0; k < receivers.size(); k++ ) {
+		i = receivers[k];
+		if( loopAt[i] != par->getcurrtime() ) {
+			app_event event;
+			event.node = i;
+			event.type = NODE_LOOP;
+			nodes.push_back(event);
+		}
 	}
+	events.advance(par->getcurrtime(), due);
+	for( k = 0; k < due.size(); k++ ) {
+		i = due[k].node;
+		if( i < 0 ) {
+			continue;
+		}
+		if( due[k].type == NODE_LOOP ) {
+			if( loopAt[i] != par->getcurrtime() || mp1[i]->getMemberNode()->bFailed ) {
+				// rescheduled since, or failed for good
+				continue;
+			}
+			loopAt[i] = -1;
+		}
+		nodes.push_back(due[k]);
+	}
+	sort(nodes.begin(), nodes.end(), [](const app_event &a, const app_event &b) { return a.node > b.node; });
 
-	// For all the nodes in the system
-	for( i = par->EN_GPSZ - 1; i >= 0; i-- ) {
+	// For the nodes with work due, from the last one down
+	runPhase(nodes.size(), [&](int task) {
+		int i = nodes[task].node;
 
 		/*
 		 * Introduce nodes into the distributed system
 		 */
-		if( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
+		if( nodes[task].type == NODE_START ) {
 			// introduce the ith node into the system at time STEPRATE*i
 			mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
-			cout<<i<<"-th introduced node is assigned with the address: "<<mp1[i]->getMemberNode()->addr.getAddress() << endl;
-			nodeCount += i;
 		}
 
 		/*
 		 * Handle all the messages in your queue and send heartbeats
 		 */
-		else if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
+		else {
 			// handle messages and send heartbeats
 			mp1[i]->nodeLoop();
 			#ifdef DEBUGLOG
@@ -160,7 +397,90 @@ void Application::mp1Run() {
 			#endif
 		}
 
+	});
+
+	// Announce the nodes introduced in this tick and loop every node again at its next deadline
+	for( k = 0; k < nodes.size(); k++ ) {
+		i = nodes[k].node;
+		if( nodes[k].type == NODE_START ) {
+			cout<<i<<"-th introduced node is assigned with the address: "<<mp1[i]->getMemberNode()->addr.getAddress() << endl;
+			nodeCount += i;
+		}
+		scheduleLoop(i);
+	}
+}
+
+/**
+ * FUNCTION NAME: runPhase
+ *
+ * DESCRIPTION: Run task(0) ... task(tasks - 1) on the executor and wait for all of them.
+ * 				The messages and log lines of the tasks are staged and released in
+ * 				task order afterwards, so a run with a fixed SEED gives the same
+ * 				results with any number of THREADS.
+ */
+void Application::runPhase(int tasks, const function<void(int)> &task) {
+	if ( tasks == 0 ) {
+		return;
+	}
+	en->ENstage(tasks);
+	log->stage(tasks);
+	exec->run(tasks, task);
+	en->ENflush();
+	log->flush();
+}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Have the event of the given type run for node at tick time
+ */
+void Application::schedule(int time, int node, int type) {
+	app_event event;
+
+	event.node = node;
+	event.type = type;
+	events.schedule(time, event);
+}
+
+/**
+ * FUNCTION NAME: scheduleLoop
+ *
+ * DESCRIPTION: Have node i loop again at its next deadline, unless that loop is
+ * 				already scheduled; a node without one loops when messages arrive
+ */
+void Application::scheduleLoop(int i) {
+	int next = mp1[i]->nextLoop();
+
+	if ( next == loopAt[i] ) {
+		return;
+	}
+	loopAt[i] = next;
+	if ( next >= 0 ) {
+		schedule(next, i, NODE_LOOP);
+	}
+}
+
+/**
+ * FUNCTION NAME: nextTime
+ *
+ * DESCRIPTION: Next tick in which a node has work due or messages to pick up,
+ * 				or a scripted step runs. Quiet ticks in between are skipped.
+ */
+int Application::nextTime() {
+	int next = par->getcurrtime() + 1;
+	int event = events.nextDue();
+	int delivery = en->ENnextDelivery();
+
+	if ( !held.empty() ) {
+		return next;
+	}
+	if ( delivery >= 0 && (event < 0 || delivery < event) ) {
+		event = delivery;
 	}
+	if ( event < 0 ) {
+		return par->TOTAL_RUNNING_TIME;
+	}
+	return event > next ? event : next;
 }
 
 /**
@@ -171,25 +491,26 @@ void Application::mp1Run() {
  * Note: this is used only by MP1
  */
 void Application::fail() {
-	int i, removed;
+	int i;
+	unsigned int k;
 
 	// fail half the members at time t=400
 	if( par->DROP_MSG && par->getcurrtime() == 50 ) {
 		par->dropmsg = 1;
 	}
 
-	if( par->SINGLE_FAILURE && par->getcurrtime() == 100 ) {
-		removed = (rand() % par->EN_GPSZ);
-		#ifdef DEBUGLOG
-		log->LOG(&mp1[removed]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-		#endif
-		mp1[removed]->getMemberNode()->bFailed = true;
-	}
-	else if( par->getcurrtime() == 100 ) {
-		removed = rand() % par->EN_GPSZ/2;
-		for ( i = removed; i < removed + par->EN_GPSZ/2; i++ ) {
+	if( par->getcurrtime() == 100 ) {
+		if ( !par->PROCESS_PER_NODE ) {
+			pickFailures();
+		}
+		for ( k = 0; k < failures.size(); k++ ) {
+			i = failures[k];
+			if ( mp1[i] == NULL ) {
+				// runs in another process, which fails it there
+				continue;
+			}
 			#ifdef DEBUGLOG
-			log->LOG(&mp1[i]->getMemberNode()->addr, "Node failed at time = %d", par->getcurrtime());
+			log->LOG(&mp1[i]->getMemberNode()->addr, par->SINGLE_FAILURE ? "Node failed at time=%d" : "Node failed at time = %d", par->getcurrtime());
 			#endif
 			mp1[i]->getMemberNode()->bFailed = true;
 		}
@@ -201,6 +522,33 @@ void Application::fail() {
 
 }
 
+/**
+ * FUNCTION NAME: pickFailures
+ *
+ * DESCRIPTION: Choose the nodes that fail at tick 100: one at random for a
+ * 				single failure, else half of them in a row. Only the nodes
+ * 				introduced by then are picked; a later one would start up
+ * 				over its failure and run anyway.
+ */
+void Application::pickFailures() {
+	int i, removed;
+	int started = 0;
+
+	while ( started < par->EN_GPSZ && (int)(par->STEP_RATE*started) <= 100 ) {
+		started++;
+	}
+
+	if( par->SINGLE_FAILURE ) {
+		failures.push_back(rand() % started);
+	}
+	else {
+		removed = rand() % started/2;
+		for ( i = removed; i < removed + started/2; i++ ) {
+			failures.push_back(i);
+		}
+	}
+}
+
 /**
  * FUNCTION NAME: getjoinaddr
  *
@@ -13,7 +13,12 @@
 #include "Params.h"
 #include "Member.h"
 #include "EmulNet.h"
-#include "Queue.h"
+#include "UdpNet.h"
+#include "ShmNet.h"
+#include "TimerWheel.h"
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 
 /**
  * global variables
@@ -24,7 +29,28 @@ int nodeCount = 0;
  * Macros
  */
 #define ARGS_COUNT 2
-#define TOTAL_RUNNING_TIME 700
+// Time node processes get to open their sockets before tick 0, in microseconds
+#define PROCESS_START_USEC 200000
+// Node processes write their msgcount.log and netstats.log to NODE_DIR/<id>/
+#define NODE_DIR "nodes"
+
+enum appEventType {
+	NODE_START,
+	NODE_LOOP,
+	APP_WAKEUP
+};
+
+/**
+ * Struct Name: app_event
+ *
+ * DESCRIPTION: Something the application layer has to do at a given tick:
+ * 				introduce a node, run its periodic loop, or run a scripted step
+ * 				such as a failure (node is -1 for those)
+ */
+typedef struct app_event {
+	int node;
+	int type;
+}app_event;
 
 /**
  * CLASS NAME: Application
@@ -38,8 +64,28 @@ private:
 	char JOINADDR[30];
 	EmulNet *en;
     Log *log;
-	MP1Node **mp1;
+	vector<MP1Node *> mp1;
 	Params *par;
+	// Runs the per-node tasks of every phase
+	Executor *exec;
+	// Node starts, node loops and scripted steps, keyed on the tick they are due
+	TimerWheel<app_event> events;
+	// Ids of nodes with messages waiting that have not started yet
+	vector<int> held;
+	// Tick of the pending NODE_LOOP of every node, -1 while it only waits for messages
+	vector<int> loopAt;
+	// Nodes that fail at tick 100
+	vector<int> failures;
+	// Pid of the process that set this run up, the generation of its shared memory rings
+	pid_t runPid;
+	EmulNet *newNet();
+	void runPhase(int tasks, const function<void(int)> &task);
+	void schedule(int time, int node, int type);
+	void scheduleLoop(int i);
+	int nextTime();
+	int runProcesses();
+	void runNode(int i, long long start);
+	void pickFailures();
 public:
 	Application(char *);
 	virtual ~Application();
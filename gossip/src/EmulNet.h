@@ -7,47 +7,90 @@
 #ifndef _EMULNET_H_
 #define _EMULNET_H_
 
-#define MAX_NODES 1000
-#define MAX_TIME 3600
-#define ENBUFFSIZE 30000
+// Traffic counters grow by this many ticks at a time
+#define COUNTER_BUCKET 256
+#define NETSTATS_LOG "netstats.log"
 
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "MsgPool.h"
+#include "TimerWheel.h"
+#include "Executor.h"
+#include "Checkpoint.h"
+#include <errno.h>
 
 using namespace std;
 
+/*
+ * Channels that share the network; the receiver gets the messages of each channel
+ * in its own queue, see ENrecvBatch
+ */
+enum enChannel { MEMBERSHIP_CHANNEL, KV_CHANNEL, EN_CHANNELS };
+
+/**
+ * Struct Name: en_buf
+ *
+ * DESCRIPTION: Header of a message buffer. The payload follows the struct and is
+ * 				what senders fill and receivers get, so a message is never copied
+ * 				between ENsend and the receive queue.
+ */
+typedef struct en_buf {
+	// Number of envelopes and receivers still holding the buffer
+	int refs;
+	// Number of bytes after the struct
+	int size;
+	// Channel the message travels on, see enChannel
+	int channel;
+}en_buf;
+
 /**
  * Struct Name: en_msg
  */
 typedef struct en_msg {
-	// Number of bytes after the class
+	// Number of bytes in the payload
 	int size;
 	// Source node
 	Address from;
 	// Destination node
 	Address to;
+	// Channel the message travels on, see enChannel
+	int channel;
+	// Payload, owned through the refcount of its en_buf
+	char *data;
 }en_msg;
 
+/**
+ * Struct Name: en_staged
+ *
+ * DESCRIPTION: A send held back while node tasks run in parallel, see ENstage
+ */
+typedef struct en_staged {
+	Address from;
+	Address to;
+	char *data;
+}en_staged;
+
 /**
  * Class Name: EM
  */
 class EM {
 public:
 	int nextid;
+	// Number of messages in flight across all mailboxes
 	int currbuffsize;
+	// High-water mark of currbuffsize
+	int peakbuffsize;
 	int firsteltindex;
-	en_msg* buff[ENBUFFSIZE];
+	// Per-destination mailboxes, indexed by the node id assigned in ENinit
+	vector< vector<en_msg *> > mailbox;
 	EM() {}
 	EM& operator = (EM &anotherEM) {
 		this->nextid = anotherEM.getNextId();
 		this->currbuffsize = anotherEM.getCurrBuffSize();
+		this->peakbuffsize = anotherEM.peakbuffsize;
 		this->firsteltindex = anotherEM.getFirstEltIndex();
-		int i = this->currbuffsize;
-		while (i > 0) {
-			this->buff[i] = anotherEM.buff[i];
-			i--;
-		}
+		this->mailbox = anotherEM.mailbox;
 		return *this;
 	}
 	int getNextId() {
@@ -78,22 +121,81 @@ public:
  */
 class EmulNet
 { 	
-private:
+protected:
 	Params* par;
-	int sent_msgs[MAX_NODES + 1][MAX_TIME];
-	int recv_msgs[MAX_NODES + 1][MAX_TIME];
+	// Messages sent/received per channel, node id and tick, rows grow by COUNTER_BUCKET
+	vector< vector< vector<int> > > sent_msgs;
+	vector< vector< vector<int> > > recv_msgs;
 	int enInited;
 	EM emulnet;
+	// Backing store of every envelope and every buffer handed to a receiver
+	MsgPool pool;
+	// Messages dropped because the network or the destination mailbox was full
+	unsigned long overflowDrops;
+	// Messages dropped by the MSG_DROP_PROB loss model
+	unsigned long randomDrops;
+	// Messages dropped because they exceed MAX_MSG_SIZE
+	unsigned long oversizeDrops;
+	// Payload bytes put on the network per channel, every copy counted
+	vector<unsigned long> sentBytes;
+	// Messages on the wire, released into mailboxes when due
+	TimerWheel<en_msg *> wire;
+	// Per node id, the (fractional) tick at which its egress link is free again
+	vector<double> linkFree;
+	// Number of messages that spent at least one tick on the wire, and their total and worst delay
+	unsigned long delayedMsgs;
+	double totalDelay;
+	double maxDelay;
+	// Sends of every task of the running phase while staging, see ENstage
+	vector< vector<en_staged> > outbox;
+	bool staging;
+	// Node ids whose mailbox got messages since the last ENready, and a flag per id
+	vector<int> readyIds;
+	vector<char> readyFlag;
+	// Taken by the calls node tasks make concurrently: ENalloc, ENfree, ENrecvBatch
+	recursive_mutex netLock;
+	// Id of the only node of this process when every node runs in a process of its own, else -1
+	int soloId;
+	vector<en_msg *> *getMailbox(Address *addr);
+	void countMsg(vector< vector<int> > &counts, int node, int time, int n = 1);
+	int getCount(vector< vector<int> > &counts, int node, int time);
+	void printCounts(FILE *file, int channel);
+	double linkDelay(int src, int size);
+	void deliverDue();
+	void park(en_msg *em, int due);
+	void markReady(int id);
+	void checkpointMsg(Checkpoint &cp, en_msg *&em);
+	// Put a message on its way to em->to
+	virtual void transmit(en_msg *em);
+	// Make messages that have reached addr visible in its mailbox
+	virtual void collect(Address *addr);
 public:
  	EmulNet(Params *p);
- 	EmulNet(EmulNet &anotherEmulNet);
- 	EmulNet& operator = (EmulNet &anotherEmulNet);
+ 	// The mailboxes and the wire hold buffers of this EmulNet's pool, so it is never copied
+ 	EmulNet(const EmulNet &anotherEmulNet) = delete;
+ 	EmulNet& operator = (const EmulNet &anotherEmulNet) = delete;
  	virtual ~EmulNet();
-	void *ENinit(Address *myaddr, short port);
-	int ENsend(Address *myaddr, Address *toaddr, string data);
-	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
-	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
-	int ENcleanup();
+	virtual void *ENinit(Address *myaddr, short port);
+	int ENsend(Address *myaddr, Address *toaddr, string data, int channel = MEMBERSHIP_CHANNEL);
+	int ENsend(Address *myaddr, Address *toaddr, char *data, int size, int channel = MEMBERSHIP_CHANNEL);
+	char *ENalloc(int size, int channel = MEMBERSHIP_CHANNEL);
+	virtual int ENmaxSize();
+	int ENsendBuffer(Address *myaddr, Address *toaddr, char *buff);
+	int ENsendMulti(Address *myaddr, vector<Address> &toaddrs, char *buff);
+	int ENsendMulti(Address *myaddr, vector<Address> &toaddrs, string data, int channel = MEMBERSHIP_CHANNEL);
+	int ENrecvBatch(Address *myaddr, vector<q_elt> &batch);
+	int ENrecvBatch(Address *myaddr, vector<q_elt> *queues[EN_CHANNELS]);
+	void ENfree(void *data);
+	void ENready(vector<int> &ids);
+	void ENsolo(int id);
+	virtual void ENwait(Address *myaddr, long long deadline);
+	static long long ENclock();
+	int ENnextDelivery();
+	void ENstage(int tasks);
+	void ENflush();
+	void ENcheckpoint(Checkpoint &cp);
+	void ENcheckpoint(Checkpoint &cp, vector<q_elt> &queue);
+	virtual int ENcleanup();
 };
 
 #endif /* _EMULNET_H_ */
@@ -0,0 +1,209 @@
+/**********************************
+ * FILE NAME: Executor.cpp
+ *
+ * DESCRIPTION: Definition of the thread pool that runs the per-node tasks of a tick
+ **********************************/
+
+#include "Executor.h"
+
+thread_local int Executor::current = -1;
+
+/**
+ * Constructor
+ *
+ * Starts threads - 1 workers, the thread calling run() is worker 0
+ */
+Executor::Executor(int threads): job(NULL), generation(0), running(0), stopping(false), phases(0), sumUtilization(0), minUtilization(1), wall(0) {
+	nworkers = threads > 0 ? threads : 1;
+	workers = new exec_worker[nworkers];
+	for ( int i = 0; i < nworkers; i++ ) {
+		workers[i].ran = 0;
+		workers[i].stolen = 0;
+		workers[i].busy = 0;
+		workers[i].phaseBusy = 0;
+	}
+	for ( int i = 1; i < nworkers; i++ ) {
+		this->threads.push_back(thread(&Executor::work, this, i));
+	}
+}
+
+/**
+ * Destructor
+ */
+Executor::~Executor() {
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+	start.notify_all();
+	for ( unsigned int i = 0; i < threads.size(); i++ ) {
+		threads[i].join();
+	}
+	delete [] workers;
+}
+
+/**
+ * FUNCTION NAME: work
+ *
+ * DESCRIPTION: Main loop of a worker thread: wait for a job, run tasks until none is left, report back
+ */
+void Executor::work(int worker) {
+	unsigned long seen = 0;
+
+	while ( 1 ) {
+		{
+			unique_lock<mutex> guard(lock);
+			start.wait(guard, [&] { return stopping || generation != seen; });
+			if ( stopping ) {
+				return;
+			}
+			seen = generation;
+		}
+
+		runShare(worker);
+
+		{
+			unique_lock<mutex> guard(lock);
+			if ( --running == 0 ) {
+				done.notify_one();
+			}
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Take the next task of the worker: the back of its own deque,
+ * 				or else the front of the first other deque that has work
+ *
+ * RETURNS:
+ * false once every deque is empty
+ */
+bool Executor::next(int worker, int &task) {
+	exec_worker &self = workers[worker];
+
+	{
+		lock_guard<mutex> guard(self.lock);
+		if ( !self.tasks.empty() ) {
+			task = self.tasks.back();
+			self.tasks.pop_back();
+			return true;
+		}
+	}
+
+	for ( int i = 1; i < nworkers; i++ ) {
+		exec_worker &victim = workers[(worker + i) % nworkers];
+		lock_guard<mutex> guard(victim.lock);
+		if ( !victim.tasks.empty() ) {
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+			self.stolen++;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * FUNCTION NAME: runShare
+ *
+ * DESCRIPTION: Run tasks of the current job on the given worker until none is left
+ */
+void Executor::runShare(int worker) {
+	exec_worker &self = workers[worker];
+	int task;
+
+	while ( next(worker, task) ) {
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		current = task;
+		(*job)(task);
+		self.phaseBusy += chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+		self.ran++;
+	}
+	current = -1;
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Run job(0) ... job(tasks - 1) across the pool and wait for all of them
+ */
+void Executor::run(int tasks, const function<void(int)> &job) {
+	chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+	int i, w;
+
+	this->job = &job;
+	// Contiguous blocks, stolen from the front so the owner keeps its cache-warm end
+	for ( w = 0; w < nworkers; w++ ) {
+		workers[w].phaseBusy = 0;
+		for ( i = (long)tasks * w / nworkers; i < (long)tasks * (w + 1) / nworkers; i++ ) {
+			workers[w].tasks.push_back(i);
+		}
+	}
+
+	if ( threads.empty() ) {
+		runShare(0);
+	}
+	else {
+		{
+			unique_lock<mutex> guard(lock);
+			running = threads.size();
+			generation++;
+		}
+		start.notify_all();
+
+		runShare(0);
+
+		unique_lock<mutex> guard(lock);
+		done.wait(guard, [&] { return running == 0; });
+	}
+
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	double busy = 0;
+	for ( w = 0; w < nworkers; w++ ) {
+		busy += workers[w].phaseBusy;
+		workers[w].busy += workers[w].phaseBusy;
+	}
+	if ( elapsed > 0 && tasks > 0 ) {
+		double utilization = busy / (elapsed * nworkers);
+		phases++;
+		sumUtilization += utilization;
+		if ( utilization < minUtilization ) {
+			minUtilization = utilization;
+		}
+	}
+	wall += elapsed;
+}
+
+/**
+ * FUNCTION NAME: getThreads
+ *
+ * DESCRIPTION: getter
+ */
+int Executor::getThreads() {
+	return nworkers;
+}
+
+/**
+ * FUNCTION NAME: printStats
+ *
+ * DESCRIPTION: Print how busy the workers were: overall and per phase utilization,
+ * 				then the tasks, steals and busy time of every worker
+ */
+void Executor::printStats(FILE *file) {
+	fprintf(file, "executor threads %d phases %lu wall_s %.6f\n", nworkers, phases, wall);
+	fprintf(file, "utilization mean %.4f min %.4f\n", phases ? sumUtilization / phases : 0.0, phases ? minUtilization : 0.0);
+	for ( int w = 0; w < nworkers; w++ ) {
+		fprintf(file, "worker %d tasks %lu stolen %lu busy_s %.6f utilization %.4f\n", w, workers[w].ran, workers[w].stolen, workers[w].busy, wall > 0 ? workers[w].busy / wall : 0.0);
+	}
+}
+
+/**
+ * FUNCTION NAME: currentTask
+ *
+ * DESCRIPTION: Index of the task the calling thread is running, -1 outside of run()
+ */
+int Executor::currentTask() {
+	return current;
+}
@@ -0,0 +1,88 @@
+/**********************************
+ * FILE NAME: Executor.h
+ *
+ * DESCRIPTION: Header file of the thread pool that runs the per-node tasks of a tick
+ **********************************/
+
+#ifndef _EXECUTOR_H_
+#define _EXECUTOR_H_
+
+#include "stdincludes.h"
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+
+/*
+ * Macros
+ */
+#define EXECSTATS_LOG "execstats.log"
+
+/**
+ * Struct Name: exec_worker
+ *
+ * DESCRIPTION: Task deque and counters of one worker. The owner takes tasks
+ * 				from the back, idle workers steal from the front.
+ */
+typedef struct exec_worker {
+	mutex lock;
+	deque<int> tasks;
+	// Tasks run and tasks stolen from other workers, over the whole run
+	unsigned long ran;
+	unsigned long stolen;
+	// Seconds spent inside tasks, over the whole run and in the current phase
+	double busy;
+	double phaseBusy;
+}exec_worker;
+
+/**
+ * CLASS NAME: Executor
+ *
+ * DESCRIPTION: Fixed pool of threads that runs one phase of a tick: task i of
+ * 				run(tasks, job) calls job(i), and run returns once every task
+ * 				is done, which is the barrier between two phases. The calling
+ * 				thread works too, so an Executor of one thread runs everything
+ * 				inline. Every worker starts a phase with a contiguous block of
+ * 				tasks in its deque and steals from the others once it runs dry,
+ * 				so a few expensive nodes (the introducer, hot coordinators) do
+ * 				not leave the other threads idle. While a task runs,
+ * 				currentTask() tells which one it is, so shared modules can hold
+ * 				back its side effects.
+ */
+class Executor {
+private:
+	vector<thread> threads;
+	exec_worker *workers;
+	int nworkers;
+	mutex lock;
+	condition_variable start;
+	condition_variable done;
+	const function<void(int)> *job;
+	// Bumped for every job so workers can tell a new one from a spurious wakeup
+	unsigned long generation;
+	// Workers still busy with the current job
+	int running;
+	bool stopping;
+	// Phases run, with the sum and the lowest of their utilization
+	unsigned long phases;
+	double sumUtilization;
+	double minUtilization;
+	double wall;
+	static thread_local int current;
+	void work(int worker);
+	void runShare(int worker);
+	bool next(int worker, int &task);
+public:
+	Executor(int threads);
+	Executor(const Executor &anotherExecutor) = delete;
+	Executor& operator =(const Executor &anotherExecutor) = delete;
+	virtual ~Executor();
+	void run(int tasks, const function<void(int)> &job);
+	int getThreads();
+	void printStats(FILE *file);
+	static int currentTask();
+};
+
+#endif /* _EXECUTOR_H_ */
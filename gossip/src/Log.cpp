@@ -12,6 +12,10 @@
 Log::Log(Params *p) {
 	par = p;
 	firstTime = false;
+	fp = NULL;
+	fp2 = NULL;
+	numwrites = 0;
+	staging = false;
 }
 
 /**
@@ -20,6 +24,10 @@ Log::Log(Params *p) {
 Log::Log(const Log &anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	this->fp = anotherLog.fp;
+	this->fp2 = anotherLog.fp2;
+	this->numwrites = anotherLog.numwrites;
+	this->staging = false;
 }
 
 /**
@@ -28,6 +36,10 @@ Log::Log(const Log &anotherLog) {
 Log& Log::operator = (const Log& anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	this->fp = anotherLog.fp;
+	this->fp2 = anotherLog.fp2;
+	this->numwrites = anotherLog.numwrites;
+	this->staging = false;
 	return *this;
 }
 
@@ -43,38 +55,38 @@ Log::~Log() {}
  */
 void Log::LOG(Address *addr, const char * str, ...) {
 
-	static FILE *fp;
-	static FILE *fp2;
 	va_list vararglist;
-	static char buffer[30000];
-	static int numwrites;
-	static char stdstring[30];
-	static char stdstring2[40];
-	static char stdstring3[40]; 
-	static int dbg_opened=0;
-
-	if(dbg_opened != 639){
-		numwrites=0;
-
-		stdstring2[0]=0;
+	char buffer[30000];
+	char stdstring[30];
+	int task = Executor::currentTask();
 
-		strcpy(stdstring3, stdstring2);
-
-		strcat(stdstring2, DBG_LOG);
-		strcat(stdstring3, STATS_LOG);
+	sprintf(stdstring, "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], *(short *)&addr->addr[4]);
 
-		fp = fopen(stdstring2, "w");
-		fp2 = fopen(stdstring3, "w");
+	va_start(vararglist, str);
+	vsnprintf(buffer, sizeof(buffer), str, vararglist);
+	va_end(vararglist);
 
-		dbg_opened=639;
+	if ( staging && task >= 0 ) {
+		// Logged from a node task: keep it for flush
+		pending[task].push_back(make_pair(string(stdstring), string(buffer)));
+		return;
 	}
-	else 
 
-	sprintf(stdstring, "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], *(short *)&addr->addr[4]);
+	write(stdstring, buffer);
+}
 
-	va_start(vararglist, str);
-	vsprintf(buffer, str, vararglist);
-	va_end(vararglist);
+/**
+ * FUNCTION NAME: write
+ *
+ * DESCRIPTION: Write one formatted line to dbg.log, or to stats.log for #STATSLOG# lines
+ */
+void Log::write(const char *stdstring, const char *buffer) {
+
+	if ( fp == NULL ) {
+		numwrites = 0;
+		fp = fopen(DBG_LOG, "w");
+		fp2 = fopen(STATS_LOG, "w");
+	}
 
 	if (!firstTime) {
 		int magicNumber = 0;
@@ -91,12 +103,12 @@ void Log::LOG(Address *addr, const char * str, ...) {
 		fprintf(fp2, "\n %s", stdstring);
 		fprintf(fp2, "[%d] ", par->getcurrtime());
 
-		fprintf(fp2, buffer);
+		fputs(buffer, fp2);
 	}
 	else{
 		fprintf(fp, "\n %s", stdstring);
 		fprintf(fp, "[%d] ", par->getcurrtime());
-		fprintf(fp, buffer);
+		fputs(buffer, fp);
 
 	}
 
@@ -114,7 +126,7 @@ void Log::LOG(Address *addr, const char * str, ...) {
  * DESCRIPTION: To Log a node add
  */
 void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
-	static char stdstring[100];
+	char stdstring[100];
 	sprintf(stdstring, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], *(short *)&addedAddr->addr[4], par->getcurrtime());
     LOG(thisNode, stdstring);
 }
@@ -125,7 +137,35 @@ void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
  * DESCRIPTION: To log a node remove
  */
 void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
-	static char stdstring[30];
+	char stdstring[100];
 	sprintf(stdstring, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], *(short *)&removedAddr->addr[4], par->getcurrtime());
     LOG(thisNode, stdstring);
 }
+
+/**
+ * FUNCTION NAME: stage
+ *
+ * DESCRIPTION: Hold back the lines node tasks log until flush, so that the
+ * 				log reads the same whatever order the tasks ran in
+ */
+void Log::stage(int tasks) {
+	if ( (int)pending.size() < tasks ) {
+		pending.resize(tasks);
+	}
+	staging = true;
+}
+
+/**
+ * FUNCTION NAME: flush
+ *
+ * DESCRIPTION: Write what the tasks logged, in task order, and stop staging
+ */
+void Log::flush() {
+	staging = false;
+	for ( unsigned int i = 0; i < pending.size(); i++ ) {
+		for ( unsigned int j = 0; j < pending[i].size(); j++ ) {
+			write(pending[i][j].first.c_str(), pending[i][j].second.c_str());
+		}
+		pending[i].clear();
+	}
+}
@@ -10,6 +10,7 @@
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "Executor.h"
 
 /*
  * Macros
@@ -29,6 +30,13 @@ class Log{
 private:
 	Params *par;
 	bool firstTime;
+	FILE *fp;
+	FILE *fp2;
+	int numwrites;
+	// Lines logged by every task of the running phase while staging, see stage
+	vector< vector< pair<string, string> > > pending;
+	bool staging;
+	void write(const char *stdstring, const char *buffer);
 public:
 	Log(Params *p);
 	Log(const Log &anotherLog);
@@ -37,6 +45,8 @@ public:
 	void LOG(Address *, const char * str, ...);
 	void logNodeAdd(Address *, Address *);
 	void logNodeRemove(Address *, Address *);
+	void stage(int tasks);
+	void flush();
 };
 
 #endif /* _LOG_H_ */
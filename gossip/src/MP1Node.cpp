@@ -7,6 +7,56 @@
 
 #include "MP1Node.h"
 
+/*
+ * Variable-length integers of the membership wire format: seven bits a byte,
+ * least significant first, the high bit set on every byte but the last
+ */
+static int varintSize(unsigned long value) {
+	int n = 1;
+
+	while ( value >= 0x80 ) {
+		value >>= 7;
+		n++;
+	}
+	return n;
+}
+
+static char *putVarint(char *p, unsigned long value) {
+	while ( value >= 0x80 ) {
+		*p++ = (char)(value | 0x80);
+		value >>= 7;
+	}
+	*p++ = (char)value;
+	return p;
+}
+
+// false if the varint runs past end
+static bool getVarint(char *&p, char *end, unsigned long &value) {
+	value = 0;
+	for ( int shift = 0; p < end && shift < 64; shift += 7 ) {
+		unsigned char b = *p++;
+		value |= (unsigned long)(b & 0x7f) << shift;
+		if ( !(b & 0x80) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Signed values go zigzag coded, so that -1 is as short as 1
+static unsigned long zigzag(long value) {
+	return ((unsigned long)value << 1) ^ (unsigned long)(value >> 63);
+}
+
+static long unzigzag(unsigned long value) {
+	return (long)(value >> 1) ^ -(long)(value & 1);
+}
+
+// Bytes of one entry of a membership list, prev being the id of the entry before it
+static int entrySize(MemberListEntry &entry, unsigned int prev) {
+	return varintSize((unsigned int)entry.id - prev) + varintSize((unsigned short)entry.port) + varintSize(zigzag(entry.heartbeat));
+}
+
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
  */
@@ -25,6 +75,9 @@ MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Addres
 	this->log = log;
 	this->par = params;
 	this->memberNode->addr = *address;
+	this->seed = rand();
+	this->nextHeartbeat = 0;
+	this->lastFullSync = -1;
 }
 
 /**
@@ -43,20 +96,10 @@ int MP1Node::recvLoop() {
     	return false;
     }
     else {
-    	return emulNet->ENrecv(&(memberNode->addr), enqueueWrapper, NULL, 1, &(memberNode->mp1q));
+    	return emulNet->ENrecvBatch(&(memberNode->addr), memberNode->mp1q);
     }
 }
 
-/**
- * FUNCTION NAME: enqueueWrapper
- *
- * DESCRIPTION: Enqueue the message from Emulnet into the queue
- */
-int MP1Node::enqueueWrapper(void *env, char *buff, int size) {
-	Queue q;
-	return q.enqueue((queue<q_elt> *)env, (void *)buff, size);
-}
-
 /**
  * FUNCTION NAME: nodeStart
  *
@@ -105,6 +148,7 @@ int MP1Node::initThisNode(Address *joinaddr) {
     // node is up!
 	memberNode->nnb = 0;
 	memberNode->heartbeat = 0;
+	nextHeartbeat = 0;
 	memberNode->pingCounter = TFAIL;
 	memberNode->timeOutCounter = -1;
     initMemberListTable(memberNode);
@@ -120,10 +164,10 @@ int MP1Node::initThisNode(Address *joinaddr) {
 int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 	MessageHdr *msg;
 #ifdef DEBUGLOG
-    static char s[1024];
+    char s[1024];
 #endif
 
-    if ( 0 == memcmp((char *)&(memberNode->addr.addr), (char *)&(joinaddr->addr), sizeof(memberNode->addr.addr))) {
+    if ( memberNode->addr == *joinaddr ) {
         // I am the group booter (first process to join the group). Boot up the group
 #ifdef DEBUGLOG
         log->LOG(&memberNode->addr, "Starting up group...");
@@ -135,7 +179,7 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 	memcpy(&port, &memberNode->addr.addr[4], sizeof(short));
 	assert(memberNode->memberList.size() == 0);
 	MemberListEntry entry(id,port,memberNode->heartbeat/*heartbeat*/,par->getcurrtime());
-	memberNode->memberList.push_back(entry);
+	addMember(entry);
         log->LOG(&memberNode->addr, "introduceSelfToGroup");
 	log->logNodeAdd(&memberNode->addr, &memberNode->addr);
     }
@@ -163,6 +207,37 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 
 }
 
+/**
+ * FUNCTION NAME: bootstrap
+ *
+ * DESCRIPTION: Start up already in the group, with members as the converged
+ * 				membership list, instead of joining through the introducer
+ */
+void MP1Node::bootstrap(vector<MemberListEntry> &members) {
+	Address joinaddr = getJoinAddress();
+	NodeId self = memberNode->addr.getNodeId();
+
+	initThisNode(&joinaddr);
+	memberNode->inGroup = true;
+
+	// first entry of memberList is self
+	memberNode->memberList.reserve(members.size());
+	memberIndex.reserve(members.size());
+	addMember(MemberListEntry(*(int *)(&memberNode->addr.addr), *(short *)(&memberNode->addr.addr[4]), memberNode->heartbeat, par->getcurrtime()));
+	for ( unsigned int i = 0; i < members.size(); i++ ) {
+		if ( members[i].getnodeid() != self ) {
+			addMember(MemberListEntry(members[i].getid(), members[i].getport(), 0, par->getcurrtime()));
+		}
+	}
+
+	if ( par->DETAILED_LOGS ) {
+		for ( unsigned int i = 0; i < memberNode->memberList.size(); i++ ) {
+			Address addr = getAddress(memberNode->memberList[i].getid(), memberNode->memberList[i].getport());
+			log->logNodeAdd(&memberNode->addr, &addr);
+		}
+	}
+}
+
 /**
  * FUNCTION NAME: finishUpThisNode
  *
@@ -194,27 +269,54 @@ void MP1Node::nodeLoop() {
     }
 
     // ...then jump in and share your responsibilites!
-    nodeLoopOps();
+    if ( par->getcurrtime() >= nextHeartbeat ) {
+        nextHeartbeat = par->getcurrtime() + THEARTBEAT;
+        nodeLoopOps();
+    }
+    else {
+        // woken between two rounds by a message or a member deadline
+        expireMembers(true);
+    }
 
     return;
 }
 
+/**
+ * FUNCTION NAME: nextLoop
+ *
+ * DESCRIPTION: Tick at which this node next has work of its own: its next gossip
+ * 				round or the next member deadline. Messages wake it up in between.
+ *
+ * RETURNS:
+ * -1 if it only has to loop when messages arrive, before it is in the group or once failed
+ */
+int MP1Node::nextLoop() {
+    int now = par->getcurrtime();
+    int next = nextHeartbeat;
+    int due = expiry.nextDue();
+
+    if ( memberNode->bFailed || !memberNode->inGroup ) {
+        return -1;
+    }
+    if ( due >= 0 && due < next ) {
+        next = due;
+    }
+    return next > now ? next : now + 1;
+}
+
 /**
  * FUNCTION NAME: checkMessages
  *
  * DESCRIPTION: Check messages in the queue and call the respective message handler
  */
 void MP1Node::checkMessages() {
-    void *ptr;
-    int size;
-
-    // Pop waiting messages from memberNode's mp1q
-    while ( !memberNode->mp1q.empty() ) {
-    	ptr = memberNode->mp1q.front().elt;
-    	size = memberNode->mp1q.front().size;
-    	memberNode->mp1q.pop();
-    	recvCallBack((void *)memberNode, (char *)ptr, size);
+    // Handle the batch of waiting messages in memberNode's mp1q in arrival order
+    for ( unsigned int i = 0; i < memberNode->mp1q.size(); i++ ) {
+    	q_elt &msg = memberNode->mp1q[i];
+    	recvCallBack((void *)memberNode, (char *)msg.elt, msg.size);
+    	emulNet->ENfree(msg.elt);
     }
+    memberNode->mp1q.clear();
     return;
 }
 
@@ -236,21 +338,26 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
         send(addr, JOINREP);
 
     } else if (msg->msgType == JOINREP) {
-        memberNode->inGroup = true;
-        int id;
-	short port;
-	memcpy(&id, &memberNode->addr.addr[0], sizeof(int));
-	memcpy(&port, &memberNode->addr.addr[4], sizeof(short));
-	MemberListEntry entry(id,port,memberNode->heartbeat/*heartbeat*/,par->getcurrtime());
-	assert(memberNode->memberList.size() == 0);
-	memberNode->memberList.push_back(entry);
-	log->LOG(&memberNode->addr, "I received JOINREP, add myself");
-	log->logNodeAdd(&memberNode->addr, &memberNode->addr);
+	// a long list comes in several fragments; whichever arrives first lets this node in
+	if (!memberNode->inGroup) {
+	    memberNode->inGroup = true;
+	    int id;
+	    short port;
+	    memcpy(&id, &memberNode->addr.addr[0], sizeof(int));
+	    memcpy(&port, &memberNode->addr.addr[4], sizeof(short));
+	    MemberListEntry entry(id,port,memberNode->heartbeat/*heartbeat*/,par->getcurrtime());
+	    assert(memberNode->memberList.size() == 0);
+	    addMember(entry);
+	    log->LOG(&memberNode->addr, "I received JOINREP, add myself");
+	    log->logNodeAdd(&memberNode->addr, &memberNode->addr);
+	}
 
 	vector<MemberListEntry> receivedMembershipList;
-	deserializeMembership(data,size,receivedMembershipList);
+	unsigned long fragment, fragments;
+	deserializeMembership(data,size,receivedMembershipList,fragment,fragments);
 
-	log->LOG(&memberNode->addr, "I received JOINREP, merging from receivedMembershipList");
+	string logging = "I received JOINREP fragment " + to_string(fragment + 1) + "/" + to_string(fragments) + ", merging from receivedMembershipList";
+	log->LOG(&memberNode->addr, logging.c_str());
 	printSelfMemberList("start");
 	mergeMembership(addr,receivedMembershipList);
 	printSelfMemberList("end");
@@ -259,8 +366,12 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
 	if (memberNode->inGroup) {
 	    // condition check is necessary as this node might be reciving JOINREP and PING at the same time
 	    vector<MemberListEntry> receivedMembershipList;
-	    deserializeMembership(data,size,receivedMembershipList);
-	    log->LOG(&memberNode->addr, "I received PING, merging from receivedMembershipList");
+	    unsigned long fragment, fragments;
+	    deserializeMembership(data,size,receivedMembershipList,fragment,fragments);
+	    if ( par->DETAILED_LOGS ) {
+	        string logging = "I received PING fragment " + to_string(fragment + 1) + "/" + to_string(fragments) + ", merging from receivedMembershipList";
+	        log->LOG(&memberNode->addr, logging.c_str());
+	    }
 	    printSelfMemberList("start");
 	    mergeMembership(addr,receivedMembershipList);
 	    printSelfMemberList("end");
@@ -274,19 +385,18 @@ void MP1Node::addToMembershipList(Address& addr) {
     short port;
     memcpy(&id,   &addr.addr[0], sizeof(int));
     memcpy(&port, &addr.addr[4], sizeof(short));
+    MemberListEntry* myEntry = findMember(addr.getNodeId());
 
-    for (auto& myEntry : memberNode->memberList) {
-        if (id == myEntry.getid() && port == myEntry.getport()) {
-            //exist in the membershiplist
-	    string logging = "update time stamp for address " + addr.getAddress();
-            log->LOG(&memberNode->addr, logging.c_str());
-            myEntry.timestamp = par->getcurrtime();
-            return;
-        }
+    if (myEntry) {
+        //exist in the membershiplist
+        string logging = "update time stamp for address " + addr.getAddress();
+        log->LOG(&memberNode->addr, logging.c_str());
+        myEntry->timestamp = par->getcurrtime();
+        return;
     }
 
     MemberListEntry e(id,port,0/*heartbeat*/, par->getcurrtime());
-    memberNode->memberList.push_back(e);
+    addMember(e);
 
     log->LOG(&memberNode->addr, "I received JOINREQ");
     string logging = "update time stamp for address " + addr.getAddress();
@@ -295,19 +405,62 @@ void MP1Node::addToMembershipList(Address& addr) {
 }
 
 void MP1Node::send(Address& addr, MsgTypes type) {
+    vector<Address> addrs(1, addr);
+    send(addrs, type);
+}
 
-    markMemberList(); // TFAIL check
-    int size = memberNode->memberList.size();
-    size_t msgsize = sizeof(MessageHdr) + sizeof(Address) + sizeof(MemberListEntry)*size + 1;
-    MessageHdr* msg;
-    msg = (MessageHdr*) malloc(msgsize * sizeof(char));
-    msg->msgType = type;
-    memcpy((char*)(msg+1), &memberNode->addr.addr, sizeof(memberNode->addr.addr));
-    char* ptr = serializeMembership(memberNode->memberList);
-    memcpy((char*)(msg+1) + sizeof(memberNode->addr.addr) + 1, ptr, sizeof(MemberListEntry)*size);
+/**
+ * FUNCTION NAME: send
+ *
+ * DESCRIPTION: Serialize the membership list once and send it to every address;
+ * 				all the copies share one network buffer
+ */
+void MP1Node::send(vector<Address>& addrs, MsgTypes type) {
 
+    markMemberList(); // TFAIL check
 
-    emulNet->ENsend(&memberNode->addr, &addr, (char*) msg, msgsize);
+    vector<MemberListEntry> entries;
+    if (type == PING) {
+        pingEntries(addrs, entries);
+    } else {
+        entries = memberNode->memberList;
+    }
+    sort(entries.begin(), entries.end(), [](MemberListEntry &a, MemberListEntry &b) { return a.getnodeid() < b.getnodeid(); });
+
+    // A list too long for one message goes out in fragments that each fit; every
+    // fragment is a list of its own, so receivers merge them in whatever order they come
+    int prefix = sizeof(MessageHdr) + sizeof(Address) + 1;
+    int room = emulNet->ENmaxSize() - prefix - 3 * varintSize(entries.size() + 1);
+    vector<unsigned int> starts(1, 0);
+    unsigned int prev = 0;
+    int used = 0;
+    for (unsigned int i=0;i<entries.size();i++) {
+        int n = entrySize(entries[i], prev);
+        if (used > 0 && used + n > room) {
+            starts.push_back(i);
+            n = entrySize(entries[i], 0);
+            used = 0;
+        }
+        used += n;
+        prev = entries[i].id;
+    }
+    starts.push_back(entries.size());
+
+    for (unsigned int f=0;f+1<starts.size();f++) {
+        size_t msgsize = prefix + varintSize(f) + varintSize(starts.size() - 1) + membershipSize(entries, starts[f], starts[f+1]);
+        MessageHdr* msg;
+        // serialize straight into the network buffer, EmulNet owns it from here on
+        msg = (MessageHdr*) emulNet->ENalloc(msgsize);
+        msg->msgType = type;
+        memcpy((char*)(msg+1), &memberNode->addr.addr, sizeof(memberNode->addr.addr));
+        char* p = (char*)(msg+1) + sizeof(memberNode->addr.addr);
+        *p++ = MEMBERSHIP_WIRE_VERSION;
+        p = putVarint(p, f);
+        p = putVarint(p, starts.size() - 1);
+        serializeMembership(entries, starts[f], starts[f+1], p);
+
+        emulNet->ENsendMulti(&memberNode->addr, addrs, (char*) msg);
+    }
     //string logging = "sending to " + addr.getAddress();
     //if (type == PING) {
     //	logging += " PING";	 
@@ -317,52 +470,51 @@ void MP1Node::send(Address& addr, MsgTypes type) {
     //logging += " JOINREP"; 
     //}
     //log->LOG(&memberNode->addr, logging.c_str());
-    delete msg;
-    delete ptr;
 }
 
 void MP1Node::mergeMembership(Address& addr, vector<MemberListEntry>& receivedMembershipList) {
 
-    string logging = "I started merging received membershipList from " + addr.getAddress() + " my membershipList size = " + to_string(memberNode->memberList.size());
-    log->LOG(&memberNode->addr, logging.c_str());
+    if ( par->DETAILED_LOGS ) {
+        string logging = "I started merging received membershipList from " + addr.getAddress() + " my membershipList size = " + to_string(memberNode->memberList.size());
+        log->LOG(&memberNode->addr, logging.c_str());
+    }
     int size = receivedMembershipList.size();
     for (int i=0;i<size;i++) {
 	MemberListEntry entry = receivedMembershipList[i];
 	updateMembership(entry);
     }
-    string logging1 = "I finished merging received membershipList from " + addr.getAddress() + " my membershipList size = " + to_string(memberNode->memberList.size());
-    log->LOG(&memberNode->addr, logging1.c_str());
+    if ( par->DETAILED_LOGS ) {
+        string logging1 = "I finished merging received membershipList from " + addr.getAddress() + " my membershipList size = " + to_string(memberNode->memberList.size());
+        log->LOG(&memberNode->addr, logging1.c_str());
+    }
 }
 
 void MP1Node::updateMembership(MemberListEntry& entry) {
-    int id; //self id
-    short port; // self port
-    memcpy(&id,   &memberNode->addr.addr[0], sizeof(int));
-    memcpy(&port, &memberNode->addr.addr[4], sizeof(short));
+    MemberListEntry* myEntry = findMember(entry.getnodeid());
 
-    for (int i=0;i<memberNode->memberList.size();i++) {
-	if (memberNode->memberList[i].getid() == entry.getid() && memberNode->memberList[i].getport() == entry.getport()) {
-	    if (memberNode->memberList[i].heartbeat == -1) {
-		return;
-	    }
-	    if (entry.heartbeat > memberNode->memberList[i].heartbeat) {
-		//if (memberNode->memberList[i].heartbeat == -1) {
-                //    string logging = "update time stamp with heartbeat == -1 due to address " + getAddress(entry.getid(), entry.getport()).getAddress();
-                //    log->LOG(&memberNode->addr, logging.c_str());
-		//}
-	        memberNode->memberList[i].heartbeat = entry.heartbeat;
-	        memberNode->memberList[i].timestamp = par->getcurrtime();
-	    }
+    if (myEntry) {
+	if (myEntry->heartbeat == -1) {
 	    return;
 	}
+	if (entry.heartbeat > myEntry->heartbeat) {
+	    //if (myEntry->heartbeat == -1) {
+            //    string logging = "update time stamp with heartbeat == -1 due to address " + getAddress(entry.getid(), entry.getport()).getAddress();
+            //    log->LOG(&memberNode->addr, logging.c_str());
+	    //}
+	    myEntry->heartbeat = entry.heartbeat;
+	    myEntry->timestamp = par->getcurrtime();
+	}
+	return;
     }
     if (entry.getheartbeat() != -1) {
         MemberListEntry e(entry);
         e.timestamp = par->getcurrtime();
-        memberNode->memberList.push_back(e);
+        addMember(e);
         Address addr = getAddress(e.getid(), e.getport());
-	string logging = addr.getAddress() + " is new, added to my membershipList";
-        log->LOG(&memberNode->addr, logging.c_str());
+        if ( par->DETAILED_LOGS ) {
+            string logging = addr.getAddress() + " is new, added to my membershipList";
+            log->LOG(&memberNode->addr, logging.c_str());
+        }
         log->logNodeAdd(&memberNode->addr, &addr);
     } 
     //else 
@@ -389,63 +541,71 @@ void MP1Node::nodeLoopOps() {
 	 */
     memberNode->heartbeat++;
 
-    int id;
-    short port;
-    memcpy(&id, &memberNode->addr.addr[0], sizeof(int));
-    memcpy(&port, &memberNode->addr.addr[4], sizeof(short));
-    vector<MemberListEntry> toRemoveList;
-    vector<MemberListEntry> newMemberList;
+    MemberListEntry* self = findMember(memberNode->addr.getNodeId());
 
-    for (auto& myEntry : memberNode->memberList) {
-	if (id == myEntry.getid() && port == myEntry.getport()) {
+    if (self) {
 	// self. don't remove, but update the entry
-	    myEntry.setheartbeat(memberNode->heartbeat);
-	    myEntry.settimestamp(par->getcurrtime());
-	    continue;
-	}
-
-        if (par->getcurrtime() - myEntry.gettimestamp() >= TREMOVE) {
-            string loggingRemove = "detected removal";
-            log->LOG(&memberNode->addr, loggingRemove.c_str());
-            toRemoveList.push_back(myEntry);
-        } 
-    }
-
-    int size = memberNode->memberList.size();
-
-    for (int i=0;i<size;i++) {
-	bool found = false;
-	auto toRemoveEntry = MemberListEntry(0,0);
-    	for (auto& removeEntry : toRemoveList) {
-            if (memberNode->memberList[i].getid() == removeEntry.getid() && memberNode->memberList[i].getport() == removeEntry.getport()) {
-	    	found=true;
-		toRemoveEntry = removeEntry;
-	    }
-	}
-	if (found) {
-            Address addr = getAddress(toRemoveEntry.getid(), toRemoveEntry.getport());
-            log->logNodeRemove(&memberNode->addr, &addr);
-	} else {
-	    newMemberList.push_back(memberNode->memberList[i]);
-	}
-    
+	self->setheartbeat(memberNode->heartbeat);
+	self->settimestamp(par->getcurrtime());
     }
 
-    memberNode->memberList = newMemberList;
+    // only the members whose deadline has come are looked at
+    expireMembers(true);
 
-    size = memberNode->memberList.size();
+    int size = memberNode->memberList.size();
 
     // in gossip styple and select two neighbors by random
     // first entry of memberList is garanteed to self
     int gossips = 3;
     if (size>1) {
+	    vector<Address> neighbors;
 	    while (gossips>0) {
-	        int neighbor = rand() % (size-1) + 1; // random number from 1 to size()-1;
+	        int neighbor = rand_r(&seed) % (size-1) + 1; // random number from 1 to size()-1;
 	        auto& myEntry = memberNode->memberList[neighbor];
-                Address addr = getAddress(myEntry.getid(), myEntry.getport());
-                send(addr,PING);
+                neighbors.push_back(getAddress(myEntry.getid(), myEntry.getport()));
 	        gossips --;
 	    }
+	    send(neighbors,PING);
+    }
+}
+
+/**
+ * FUNCTION NAME: pingEntries
+ *
+ * DESCRIPTION: Members a PING to addrs carries. Without DELTA_GOSSIP, or once every
+ * 				FULL_SYNC_INTERVAL ticks, that is the whole membership list. Otherwise
+ * 				it is the live members whose heartbeat went up here, which is what
+ * 				their timestamp records, since this node last pinged any of addrs;
+ * 				a peer not pinged since the last full sync counts from that sync.
+ */
+void MP1Node::pingEntries(vector<Address>& addrs, vector<MemberListEntry>& entries) {
+    int now = par->getcurrtime();
+
+    if (!par->DELTA_GOSSIP || lastFullSync < 0 || now - lastFullSync >= par->FULL_SYNC_INTERVAL) {
+        entries = memberNode->memberList;
+        if (par->DELTA_GOSSIP) {
+            // the peers pinged before this sync only need what changes from now on
+            lastFullSync = now;
+            lastSent.clear();
+        }
+        return;
+    }
+
+    int since = now;
+    for (unsigned int i=0;i<addrs.size();i++) {
+        unordered_map<NodeId, int, NodeIdHash>::iterator it = lastSent.find(addrs[i].getNodeId());
+        int mark = it == lastSent.end() ? lastFullSync : it->second;
+        since = mark < since ? mark : since;
+    }
+    // a member updated later in the tick of the last PING was not in it, so that tick counts
+    for (unsigned int i=0;i<memberNode->memberList.size();i++) {
+        MemberListEntry &entry = memberNode->memberList[i];
+        if (entry.getheartbeat() != -1 && entry.gettimestamp() >= since) {
+            entries.push_back(entry);
+        }
+    }
+    for (unsigned int i=0;i<addrs.size();i++) {
+        lastSent[addrs[i].getNodeId()] = now;
     }
 }
 
@@ -489,6 +649,116 @@ Address MP1Node::getJoinAddress() {
  */
 void MP1Node::initMemberListTable(Member *memberNode) {
 	memberNode->memberList.clear();
+	memberIndex.clear();
+	expiry = TimerWheel<NodeId>();
+	lastFullSync = -1;
+	lastSent.clear();
+}
+
+/**
+ * FUNCTION NAME: findMember
+ *
+ * DESCRIPTION: Look a member up in the membership list by its id
+ *
+ * RETURNS:
+ * the entry, valid until the list next changes; NULL if nodeId is not a member
+ */
+MemberListEntry *MP1Node::findMember(NodeId nodeId) {
+	unordered_map<NodeId, int, NodeIdHash>::iterator it = memberIndex.find(nodeId);
+
+	return it == memberIndex.end() ? NULL : &memberNode->memberList[it->second];
+}
+
+/**
+ * FUNCTION NAME: addMember
+ *
+ * DESCRIPTION: Append entry to the membership list, index it and, unless it is
+ * 				this node, start watching its deadlines
+ */
+void MP1Node::addMember(const MemberListEntry &entry) {
+	MemberListEntry e(entry);
+	NodeId nodeId = e.getnodeid();
+
+	memberIndex[nodeId] = memberNode->memberList.size();
+	memberNode->memberList.push_back(e);
+	if ( nodeId != memberNode->addr.getNodeId() ) {
+		expiry.schedule(e.gettimestamp() + TFAIL + 1, nodeId);
+	}
+}
+
+/**
+ * FUNCTION NAME: removeMember
+ *
+ * DESCRIPTION: Take a member out of the membership list by moving the last entry
+ * 				into its place; this node stays first since it is never removed
+ */
+void MP1Node::removeMember(NodeId nodeId) {
+	unordered_map<NodeId, int, NodeIdHash>::iterator it = memberIndex.find(nodeId);
+	int last = memberNode->memberList.size() - 1;
+
+	if ( it == memberIndex.end() ) {
+		return;
+	}
+	if ( it->second != last ) {
+		memberNode->memberList[it->second] = memberNode->memberList[last];
+		memberIndex[memberNode->memberList[it->second].getnodeid()] = it->second;
+	}
+	memberNode->memberList.pop_back();
+	memberIndex.erase(it);
+}
+
+/**
+ * FUNCTION NAME: expireMembers
+ *
+ * DESCRIPTION: Handle the members whose deadline has come: mark the ones not heard
+ * 				from for more than TFAIL with heartbeat -1 and, if remove is set,
+ * 				remove the ones not heard from for TREMOVE. A member that was heard
+ * 				from in the meantime is only due again at its new deadline.
+ */
+void MP1Node::expireMembers(bool remove) {
+	vector<NodeId> due;
+	long now = par->getcurrtime();
+	long age, next;
+
+	expiry.advance(now, due);
+	for ( unsigned int i = 0; i < due.size(); i++ ) {
+		MemberListEntry *entry = findMember(due[i]);
+		if ( entry == NULL ) {
+			continue;
+		}
+		Address addr = getAddress(entry->getid(), entry->getport());
+		age = now - entry->gettimestamp();
+
+		if ( remove && age >= TREMOVE ) {
+			log->LOG(&memberNode->addr, "detected removal");
+			removeMember(due[i]);
+			log->logNodeRemove(&memberNode->addr, &addr);
+			continue;
+		}
+		if ( entry->getheartbeat() != -1 && age > TFAIL ) {
+			string logging = "detected TFAIL for address " + addr.getAddress() + " and set its heartbeat to -1";
+			logging += " reason: " + to_string(now) + " " + to_string(entry->gettimestamp());
+			log->LOG(&memberNode->addr, logging.c_str());
+			entry->setheartbeat(-1);
+		}
+
+		// a removal that comes due outside nodeLoopOps waits for it in the same tick
+		next = entry->gettimestamp() + (entry->getheartbeat() != -1 ? TFAIL + 1 : TREMOVE);
+		expiry.schedule(next > now ? next : now, due[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: indexMemberList
+ *
+ * DESCRIPTION: Rebuild the index after a checkpoint restored the membership list
+ */
+void MP1Node::indexMemberList() {
+	memberIndex.clear();
+	memberIndex.reserve(memberNode->memberList.size());
+	for ( unsigned int i = 0; i < memberNode->memberList.size(); i++ ) {
+		memberIndex[memberNode->memberList[i].getnodeid()] = i;
+	}
 }
 
 /**
@@ -501,48 +771,134 @@ void MP1Node::printAddress(Address *addr)
     printf("%d.%d.%d.%d:%d \n",  addr->addr[0],addr->addr[1],addr->addr[2],
                                                        addr->addr[3], *(short*)&addr->addr[4]) ;    
 }
-	
-char* MP1Node::serializeMembership(vector<MemberListEntry>& membershipList) {
-	int size = membershipList.size();
-	size_t totalSize = sizeof(MemberListEntry)*size;
-	MemberListEntry* ptr = (MemberListEntry*) malloc(totalSize);
 
-	for (int i=0;i<size;i++) {
-		memcpy((char*)(ptr+i), &memberNode->memberList[i], sizeof(MemberListEntry));
+/**
+ * FUNCTION NAME: checkpoint
+ *
+ * DESCRIPTION: Save or restore this node's membership state, its random number
+ * 				generator and the membership messages it has not handled yet
+ */
+void MP1Node::checkpoint(Checkpoint &cp) {
+	cp.io(seed);
+	cp.io(memberNode->addr);
+	cp.io(memberNode->inited);
+	cp.io(memberNode->inGroup);
+	cp.io(memberNode->bFailed);
+	cp.io(memberNode->nnb);
+	cp.io(memberNode->heartbeat);
+	cp.io(nextHeartbeat);
+	cp.io(lastFullSync);
+	cp.io(memberNode->pingCounter);
+	cp.io(memberNode->timeOutCounter);
+	cp.io(memberNode->memberList);
+
+	vector< pair<int, NodeId> > timers;
+	vector< pair<NodeId, int> > sent;
+	if ( cp.saving() ) {
+		expiry.list(timers);
+		sent.assign(lastSent.begin(), lastSent.end());
+	}
+	cp.io(timers);
+	cp.io(sent);
+	if ( !cp.saving() ) {
+		indexMemberList();
+		expiry = TimerWheel<NodeId>();
+		for ( unsigned int i = 0; i < timers.size(); i++ ) {
+			expiry.schedule(timers[i].first, timers[i].second);
+		}
+		lastSent.clear();
+		lastSent.insert(sent.begin(), sent.end());
 	}
-	return (char*) ptr;
+	emulNet->ENcheckpoint(cp, memberNode->mp1q);
 }
+	
+/**
+ * FUNCTION NAME: membershipSize
+ *
+ * DESCRIPTION: Bytes serializeMembership takes for entries from up to to of a
+ * 				list sorted by node id
+ */
+int MP1Node::membershipSize(vector<MemberListEntry>& membershipList, unsigned int from, unsigned int to) {
+	unsigned int prev = 0;
+	int size = varintSize(to - from);
 
+	for (unsigned int i=from;i<to;i++) {
+		size += entrySize(membershipList[i], prev);
+		prev = membershipList[i].id;
+	}
+	return size;
+}
 
-void MP1Node::deserializeMembership(char* data, int size, vector<MemberListEntry>& membershipList) {
+/**
+ * FUNCTION NAME: serializeMembership
+ *
+ * DESCRIPTION: Write entries from up to to of a list sorted by node id: their number,
+ * 				then per entry the id as the difference to the one before, the port
+ * 				and the heartbeat, all varints. Timestamps stay home; receivers set
+ * 				their own.
+ */
+void MP1Node::serializeMembership(vector<MemberListEntry>& membershipList, unsigned int from, unsigned int to, char* buff) {
+	unsigned int prev = 0;
+
+	buff = putVarint(buff, to - from);
+	for (unsigned int i=from;i<to;i++) {
+		buff = putVarint(buff, (unsigned int)membershipList[i].id - prev);
+		buff = putVarint(buff, (unsigned short)membershipList[i].port);
+		buff = putVarint(buff, zigzag(membershipList[i].heartbeat));
+		prev = membershipList[i].id;
+	}
+}
 
-	// memcpy((char *)(msg+1) + 1 + sizeof(memberNode->addr.addr), &memberNode->heartbeat, sizeof(long));
+/**
+ * FUNCTION NAME: deserializeMembership
+ *
+ * DESCRIPTION: Read the membership list of a JOINREP or PING fragment, and which
+ * 				fragment of how many it is. A list in another format is dropped;
+ * 				a truncated one gives the entries read up to the cut.
+ */
+void MP1Node::deserializeMembership(char* data, int size, vector<MemberListEntry>& membershipList, unsigned long& fragment, unsigned long& fragments) {
 	int prefixSize = sizeof(MessageHdr)+sizeof(memberNode->addr.addr)+1;
-	int allEntrySize = size - prefixSize;
-	char* ptr = (char*)(data + prefixSize);
-
-	int numOfEntries = allEntrySize/sizeof(MemberListEntry);
-	MemberListEntry* pEntry = (MemberListEntry*) ptr;
-	for (int i=0;i<numOfEntries;i++) {
-		membershipList.push_back(*pEntry);
-		pEntry++;
+	char* ptr = data + prefixSize;
+	char* end = data + size;
+	unsigned long count, delta, port, heartbeat;
+	unsigned int id = 0;
+
+	fragment = 0;
+	fragments = 1;
+	if (size < prefixSize || data[prefixSize-1] != MEMBERSHIP_WIRE_VERSION ||
+	    !getVarint(ptr, end, fragment) || !getVarint(ptr, end, fragments) || !getVarint(ptr, end, count)) {
+		log->LOG(&memberNode->addr, "dropped a membership list in an unknown format");
+		return;
+	}
+	// every entry takes three bytes at least
+	membershipList.reserve(count < (unsigned long)(end - ptr) / 3 ? count : (end - ptr) / 3);
+	for (; count > 0; count--) {
+		if (!getVarint(ptr, end, delta) || !getVarint(ptr, end, port) || !getVarint(ptr, end, heartbeat)) {
+			break;
+		}
+		id += delta;
+		membershipList.push_back(MemberListEntry((int)id, (short)port, unzigzag(heartbeat), 0));
 	}
 }
 
 void MP1Node::markMemberList() {
     printSelfMemberList("start");
-    for (auto& myEntry : memberNode->memberList) {
-        if (par->getcurrtime() - myEntry.gettimestamp() > TFAIL) {
-	    string logging = "detected TFAIL for address " + getAddress(myEntry.getid(), myEntry.getport()).getAddress() + " and set its heartbeat to -1";
-	    logging += " reason: " + to_string(par->getcurrtime()) + " " + to_string(myEntry.gettimestamp());
-	    log->LOG(&memberNode->addr, logging.c_str());
-	    myEntry.setheartbeat(-1);
-	}
+    // this node has no deadline to watch; it only lapses when it has not looped for a while
+    MemberListEntry* self = findMember(memberNode->addr.getNodeId());
+    if (self && par->getcurrtime() - self->gettimestamp() > TFAIL) {
+	string logging = "detected TFAIL for address " + memberNode->addr.getAddress() + " and set its heartbeat to -1";
+	logging += " reason: " + to_string(par->getcurrtime()) + " " + to_string(self->gettimestamp());
+	log->LOG(&memberNode->addr, logging.c_str());
+	self->setheartbeat(-1);
     }
+    expireMembers(false);
     printSelfMemberList("end");
 }
 
 void MP1Node::printSelfMemberList(string&& identifier) {
+    if (!par->DETAILED_LOGS) {
+        return;
+    }
     for (int i=0;i<memberNode->memberList.size();i++) {
         string entry = identifier;
         entry += " ";
@@ -13,13 +13,18 @@
 #include "Params.h"
 #include "Member.h"
 #include "EmulNet.h"
-#include "Queue.h"
+#include "TimerWheel.h"
+#include <unordered_map>
 
 /**
  * Macros
  */
 #define TREMOVE 20
 #define TFAIL 5
+// Ticks between two gossip rounds of a node
+#define THEARTBEAT 1
+// Format of the membership lists in JOINREP and PING, in the byte after the sender's address
+#define MEMBERSHIP_WIRE_VERSION 2
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
@@ -44,6 +49,17 @@ typedef struct MessageHdr {
 	enum MsgTypes msgType;
 }MessageHdr;
 
+/**
+ * STRUCT NAME: NodeIdHash
+ *
+ * DESCRIPTION: Hash of a NodeId for unordered containers
+ */
+struct NodeIdHash {
+	size_t operator()(NodeId nodeId) const {
+		return hashNodeId(nodeId);
+	}
+};
+
 /**
  * CLASS NAME: MP1Node
  *
@@ -56,16 +72,36 @@ private:
 	Params *par;
 	Member *memberNode;
 	char NULLADDR[6];
+	// State of this node's own random number generator, so nodes can run on any thread
+	unsigned int seed;
+	// Position of every member in memberNode->memberList, so a merge does not scan it
+	unordered_map<NodeId, int, NodeIdHash> memberIndex;
+	// Next TFAIL or TREMOVE deadline of every member but this node, checked when it comes due
+	TimerWheel<NodeId> expiry;
+	// Tick of the next gossip round of this node
+	int nextHeartbeat;
+	// With DELTA_GOSSIP: tick of this node's last PING with the whole membership list,
+	// -1 before the first, and the tick it last pinged each peer since then
+	int lastFullSync;
+	unordered_map<NodeId, int, NodeIdHash> lastSent;
 
  	void addToMembershipList(Address& addr);
 	void mergeMembership(Address& addr, vector<MemberListEntry>& membershipList);
 	void updateMembership(MemberListEntry& entry);
-	char* serializeMembership(vector<MemberListEntry>& membershipList);
-	void deserializeMembership(char* data, int size, vector<MemberListEntry>& membershipList);
+	int membershipSize(vector<MemberListEntry>& membershipList, unsigned int from, unsigned int to);
+	void serializeMembership(vector<MemberListEntry>& membershipList, unsigned int from, unsigned int to, char* buff);
+	void pingEntries(vector<Address>& addrs, vector<MemberListEntry>& entries);
+	void deserializeMembership(char* data, int size, vector<MemberListEntry>& membershipList, unsigned long& fragment, unsigned long& fragments);
  	void send(Address& addr, MsgTypes type);
+ 	void send(vector<Address>& addrs, MsgTypes type);
 	Address getAddress(int id, short port);
 	void printSelfMemberList(string&& identifier);
 	void markMemberList();
+	MemberListEntry *findMember(NodeId nodeId);
+	void addMember(const MemberListEntry &entry);
+	void indexMemberList();
+	void removeMember(NodeId nodeId);
+	void expireMembers(bool remove);
 
 public:
 	MP1Node(Member *, Params *, EmulNet *, Log *, Address *);
@@ -73,12 +109,13 @@ public:
 		return memberNode;
 	}
 	int recvLoop();
-	static int enqueueWrapper(void *env, char *buff, int size);
 	void nodeStart(char *servaddrstr, short serverport);
 	int initThisNode(Address *joinaddr);
 	int introduceSelfToGroup(Address *joinAddress);
+	void bootstrap(vector<MemberListEntry> &members);
 	int finishUpThisNode();
 	void nodeLoop();
+	int nextLoop();
 	void checkMessages();
 	bool recvCallBack(void *env, char *data, int size);
 	void nodeLoopOps();
@@ -86,6 +123,7 @@ public:
 	Address getJoinAddress();
 	void initMemberListTable(Member *memberNode);
 	void printAddress(Address *addr);
+	void checkpoint(Checkpoint &cp);
 	virtual ~MP1Node();
 };
 
@@ -33,8 +33,19 @@ Address& Address::operator =(const Address& anotherAddress) {
  * Return true/non-zero if they have the same ip address and port number 
  * Return false/zero if they are different 
  */
-bool Address::operator ==(const Address& anotherAddress) {
-	return !memcmp(this->addr, anotherAddress.addr, sizeof(this->addr));
+bool Address::operator ==(const Address& anotherAddress) const {
+	return getNodeId() == anotherAddress.getNodeId();
+}
+
+bool Address::operator !=(const Address& anotherAddress) const {
+	return getNodeId() != anotherAddress.getNodeId();
+}
+
+/**
+ * Order Address objects by node id
+ */
+bool Address::operator <(const Address& anotherAddress) const {
+	return getNodeId() < anotherAddress.getNodeId();
 }
 
 /**
@@ -87,6 +98,15 @@ short MemberListEntry::getport() {
 	return port;
 }
 
+/**
+ * FUNCTION NAME: getnodeid
+ *
+ * DESCRIPTION: Packed id and port of the member
+ */
+NodeId MemberListEntry::getnodeid() {
+	return makeNodeId(id, port);
+}
+
 /**
  * FUNCTION NAME: getheartbeat
  *
@@ -24,11 +24,33 @@ void Params::setparams(char *config_file) {
 	fscanf(fp,"\nDROP_MSG: %d", &DROP_MSG);
 	fscanf(fp,"\nMSG_DROP_PROB: %lf", &MSG_DROP_PROB);
 
+	// Optional settings follow the fixed ones, one "KEY: value" per line
+	EN_BUFFSIZE = 0;
+	EN_NODEBUFFSIZE = 0;
+	LATENCY_MODEL = NO_LATENCY;
+	LATENCY_MIN = 0;
+	LATENCY_MAX = 0;
+	LATENCY_ALPHA = 2;
+	EGRESS_BANDWIDTH = 0;
+	TRANSPORT = EMUL_TRANSPORT;
+	THREADS = 1;
+	SEED = 0;
+	TOTAL_RUNNING_TIME = 700;
+	MAX_MSG_SIZE = 4000;
+	DETAILED_LOGS = 1;
+	DELTA_GOSSIP = 0;
+	FULL_SYNC_INTERVAL = 10;
+	PROCESS_PER_NODE = 0;
+	TICK_USEC = 10000;
+	char key[64], value[64];
+	while ( fscanf(fp, " %63[^:]: %63s", key, value) == 2 ) {
+		setparam(key, value);
+	}
+
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
 	EN_GPSZ = MAX_NNB;
 	STEP_RATE=.25;
-	MAX_MSG_SIZE = 4000;
 	globaltime = 0;
 	dropmsg = 0;
 	allNodesJoined = 0;
@@ -39,6 +61,87 @@ void Params::setparams(char *config_file) {
 	return;
 }
 
+/**
+ * FUNCTION NAME: setparam
+ *
+ * DESCRIPTION: Set one optional parameter read from the test case
+ */
+void Params::setparam(char *key, char *value) {
+	if ( 0 == strcmp(key, "EN_BUFFSIZE") ) {
+		EN_BUFFSIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "EN_NODEBUFFSIZE") ) {
+		EN_NODEBUFFSIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "LATENCY_MODEL") ) {
+		if ( 0 == strcmp(value, "FIXED") ) {
+			LATENCY_MODEL = FIXED_LATENCY;
+		}
+		else if ( 0 == strcmp(value, "UNIFORM") ) {
+			LATENCY_MODEL = UNIFORM_LATENCY;
+		}
+		else if ( 0 == strcmp(value, "LONGTAIL") ) {
+			LATENCY_MODEL = LONGTAIL_LATENCY;
+		}
+		else {
+			LATENCY_MODEL = NO_LATENCY;
+		}
+	}
+	else if ( 0 == strcmp(key, "LATENCY_MIN") ) {
+		LATENCY_MIN = atof(value);
+	}
+	else if ( 0 == strcmp(key, "LATENCY_MAX") ) {
+		LATENCY_MAX = atof(value);
+	}
+	else if ( 0 == strcmp(key, "LATENCY_ALPHA") ) {
+		LATENCY_ALPHA = atof(value);
+	}
+	else if ( 0 == strcmp(key, "EGRESS_BANDWIDTH") ) {
+		EGRESS_BANDWIDTH = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "TRANSPORT") ) {
+		if ( 0 == strcmp(value, "UDP") ) {
+			TRANSPORT = UDP_TRANSPORT;
+		}
+		else if ( 0 == strcmp(value, "SHM") ) {
+			TRANSPORT = SHM_TRANSPORT;
+		}
+		else {
+			TRANSPORT = EMUL_TRANSPORT;
+		}
+	}
+	else if ( 0 == strcmp(key, "THREADS") ) {
+		THREADS = atoi(value) > 0 ? atoi(value) : 1;
+	}
+	else if ( 0 == strcmp(key, "SEED") ) {
+		SEED = strtoul(value, NULL, 10);
+	}
+	else if ( 0 == strcmp(key, "TOTAL_RUNNING_TIME") ) {
+		TOTAL_RUNNING_TIME = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "MAX_MSG_SIZE") ) {
+		MAX_MSG_SIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "DETAILED_LOGS") ) {
+		DETAILED_LOGS = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "DELTA_GOSSIP") ) {
+		DELTA_GOSSIP = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "FULL_SYNC_INTERVAL") ) {
+		FULL_SYNC_INTERVAL = atoi(value) > 0 ? atoi(value) : 10;
+	}
+	else if ( 0 == strcmp(key, "PROCESS_PER_NODE") ) {
+		PROCESS_PER_NODE = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "TICK_USEC") ) {
+		TICK_USEC = atoi(value) > 0 ? atoi(value) : 10000;
+	}
+	else {
+		printf("Ignoring unknown parameter %s\n", key);
+	}
+}
+
 /**
  * FUNCTION NAME: getcurrtime
  *
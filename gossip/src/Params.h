@@ -12,6 +12,8 @@
 #include "Member.h"
 
 enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST };
+enum latencyTYPE { NO_LATENCY, FIXED_LATENCY, UNIFORM_LATENCY, LONGTAIL_LATENCY };
+enum transportTYPE { EMUL_TRANSPORT, UDP_TRANSPORT, SHM_TRANSPORT };
 
 /**
  * CLASS NAME: Params
@@ -31,8 +33,25 @@ public:
 	int globaltime;
 	int allNodesJoined;
 	short PORTNUM;
+	int EN_BUFFSIZE;			// max messages in flight across the network, 0 for no limit
+	int EN_NODEBUFFSIZE;		// max messages waiting for a single node, 0 for no limit
+	int LATENCY_MODEL;			// link latency distribution, see latencyTYPE
+	double LATENCY_MIN;			// fixed latency, lower bound or Pareto scale, in ticks
+	double LATENCY_MAX;			// upper bound of the latency, in ticks, 0 for no cap on the long tail
+	double LATENCY_ALPHA;		// Pareto shape of the long-tail latency
+	int EGRESS_BANDWIDTH;		// bytes a node can put on the wire per tick, 0 for no limit
+	int TRANSPORT;				// in-memory, loopback UDP or shared memory network, see transportTYPE
+	int THREADS;				// threads running the per-node tasks of a tick
+	unsigned int SEED;			// seed of the random number generators, 0 to seed from the clock
+	int TOTAL_RUNNING_TIME;		// ticks to run
+	int DETAILED_LOGS;			// per-tick message counts and member list dumps, 0 to keep only totals
+	int DELTA_GOSSIP;			// 1 to have PINGs carry only the members changed since their targets were last sent to
+	int FULL_SYNC_INTERVAL;		// with DELTA_GOSSIP, ticks between two PINGs carrying the whole membership list
+	int PROCESS_PER_NODE;		// run every node in an OS process of its own, over the UDP or SHM transport
+	int TICK_USEC;				// wall-clock length of a tick when every node runs in its own process, in microseconds
 	Params();
 	void setparams(char *);
+	void setparam(char *key, char *value);
 	int getcurrtime();
 };
 
@@ -0,0 +1,295 @@
+/**********************************
+ * FILE NAME: ShmNet.cpp
+ *
+ * DESCRIPTION: Definition of the shared-memory ring transport
+ **********************************/
+
+#include "ShmNet.h"
+
+/**
+ * Constructor
+ */
+ShmNet::ShmNet(Params *p, short basePort, long generation): EmulNet(p), basePort(basePort), generation(generation),
+		ringFullDrops(0), noRingDrops(0), badSlots(0) {
+	stride = (sizeof(shm_slot) + par->MAX_MSG_SIZE + SHM_ALIGN - 1) / SHM_ALIGN * SHM_ALIGN;
+	length = sizeof(shm_ring) + SHM_RING_SLOTS * stride;
+}
+
+/**
+ * Destructor
+ */
+ShmNet::~ShmNet() {
+	for ( unsigned int i = 0; i < rings.size(); i++ ) {
+		if ( rings[i] ) {
+			munmap(rings[i], length);
+		}
+	}
+	for ( unsigned int i = 0; i < created.size(); i++ ) {
+		shm_unlink(created[i].c_str());
+	}
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Init the emulnet for this node and set up its ring
+ */
+void *ShmNet::ENinit(Address *myaddr, short port) {
+	EmulNet::ENinit(myaddr, port);
+	getRing(myaddr);
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: getRing
+ *
+ * DESCRIPTION: Return the ring of the node with the given address, mapping it
+ * 				on first use. A process creates the rings of the nodes it runs,
+ * 				every node with a single process, and opens the rest.
+ *
+ * RETURNS:
+ * NULL if the address does not carry a valid node id or the ring cannot be
+ * mapped yet; a missing ring is looked up again on the next call
+ */
+shm_ring *ShmNet::getRing(Address *addr) {
+	int id = *(int *)(addr->addr);
+	short port = *(short *)(&addr->addr[4]);
+
+	if ( id < 0 ) {
+		return NULL;
+	}
+	if ( id >= (int)rings.size() ) {
+		rings.resize(id + 1, NULL);
+	}
+	if ( rings[id] ) {
+		return rings[id];
+	}
+
+	char name[32];
+	sprintf(name, SHM_PREFIX "%d", port ? port : basePort + id);
+
+	shm_ring *ring = ( soloId < 0 || id == soloId ) ? createRing(name) : openRing(name);
+	if ( ring ) {
+		rings[id] = ring;
+	}
+	return ring;
+}
+
+/**
+ * FUNCTION NAME: createRing
+ *
+ * DESCRIPTION: Create the shared memory object of a ring and set the ring up.
+ * 				Whatever an earlier run left under the name is unlinked first,
+ * 				so a ring is never reused, even after a crash.
+ */
+shm_ring *ShmNet::createRing(const char *name) {
+	shm_unlink(name);
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if ( fd < 0 ) {
+		perror("shm_open");
+		return NULL;
+	}
+	if ( ftruncate(fd, length) < 0 ) {
+		perror("ftruncate");
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	shm_ring *ring = (shm_ring *) mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if ( ring == MAP_FAILED ) {
+		perror("mmap");
+		shm_unlink(name);
+		return NULL;
+	}
+	created.push_back(name);
+
+	ring->slots = SHM_RING_SLOTS;
+	ring->stride = stride;
+	ring->enqueuePos.store(0);
+	ring->dequeuePos.store(0);
+	for ( unsigned long i = 0; i < ring->slots; i++ ) {
+		getSlot(ring, i)->seq.store(i);
+	}
+	// senders take the ring once they see the generation of their run
+	ring->owner.store(generation, std::memory_order_release);
+	return ring;
+}
+
+/**
+ * FUNCTION NAME: openRing
+ *
+ * DESCRIPTION: Map the ring another process created for its node
+ *
+ * RETURNS:
+ * NULL if the owner has not set the ring up for this run yet
+ */
+shm_ring *ShmNet::openRing(const char *name) {
+	int fd = shm_open(name, O_RDWR, 0600);
+	if ( fd < 0 ) {
+		return NULL;
+	}
+
+	struct stat st;
+	if ( fstat(fd, &st) < 0 || (size_t)st.st_size != length ) {
+		close(fd);
+		return NULL;
+	}
+
+	shm_ring *ring = (shm_ring *) mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if ( ring == MAP_FAILED ) {
+		perror("mmap");
+		return NULL;
+	}
+	if ( ring->owner.load(std::memory_order_acquire) != generation ) {
+		// left behind by another run, or not ready yet
+		munmap(ring, length);
+		return NULL;
+	}
+	return ring;
+}
+
+/**
+ * FUNCTION NAME: getSlot
+ *
+ * DESCRIPTION: Slot of the ring that position pos maps to
+ */
+shm_slot *ShmNet::getSlot(shm_ring *ring, unsigned long pos) {
+	return (shm_slot *)((char *)(ring + 1) + (pos & (ring->slots - 1)) * ring->stride);
+}
+
+/**
+ * FUNCTION NAME: transmit
+ *
+ * DESCRIPTION: Claim a slot in the ring of the receiver, copy the message into
+ * 				it and publish it. A slot is free for position pos when its seq
+ * 				equals pos and holds a message once seq is pos + 1.
+ */
+void ShmNet::transmit(en_msg *em) {
+	shm_ring *ring = getRing(&em->to);
+	shm_slot *slot = NULL;
+
+	if ( ring && em->size <= (int)(ring->stride - sizeof(shm_slot)) ) {
+		unsigned long pos = ring->enqueuePos.load(std::memory_order_relaxed);
+		while ( 1 ) {
+			slot = getSlot(ring, pos);
+			long diff = (long)slot->seq.load(std::memory_order_acquire) - (long)pos;
+			if ( diff == 0 ) {
+				if ( ring->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) ) {
+					break;
+				}
+			}
+			else if ( diff < 0 ) {
+				// the consumer has not freed this slot yet, the ring is full
+				slot = NULL;
+				break;
+			}
+			else {
+				pos = ring->enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		if ( slot ) {
+			slot->size = em->size;
+			slot->channel = em->channel;
+			slot->from = em->from;
+			slot->to = em->to;
+			memcpy((char *)(slot + 1), em->data, em->size);
+			slot->seq.store(pos + 1, std::memory_order_release);
+			// the message waits in the ring until its node collects it
+			markReady(*(int *)(em->to.addr));
+		}
+	}
+
+	if ( ring == NULL ) {
+		noRingDrops++;
+	}
+	else if ( slot == NULL ) {
+		ringFullDrops++;
+	}
+
+	ENfree(em->data);
+	pool.release(em);
+}
+
+/**
+ * FUNCTION NAME: collect
+ *
+ * DESCRIPTION: Move every published message of the ring of addr into its mailbox
+ */
+void ShmNet::collect(Address *addr) {
+	shm_ring *ring = getRing(addr);
+
+	if ( ring == NULL ) {
+		return;
+	}
+
+	unsigned long pos = ring->dequeuePos.load(std::memory_order_relaxed);
+	while ( 1 ) {
+		shm_slot *slot = getSlot(ring, pos);
+		if ( slot->seq.load(std::memory_order_acquire) != pos + 1 ) {
+			break;
+		}
+		if ( slot->size < 0 || slot->size > (int)(ring->stride - sizeof(shm_slot))
+				|| slot->channel < 0 || slot->channel >= EN_CHANNELS ) {
+			// the ring is writable by every process, do not trust the header
+			badSlots++;
+			slot->seq.store(pos + ring->slots, std::memory_order_release);
+			pos++;
+			continue;
+		}
+
+		en_msg *em = (en_msg *) pool.allocate(sizeof(en_msg));
+		em->size = slot->size;
+		em->channel = slot->channel;
+		em->from = slot->from;
+		em->to = slot->to;
+		em->data = ENalloc(em->size);
+		memcpy(em->data, (char *)(slot + 1), em->size);
+
+		// hand the slot back to the producers for the next lap
+		slot->seq.store(pos + ring->slots, std::memory_order_release);
+		pos++;
+		park(em, par->getcurrtime());
+	}
+	ring->dequeuePos.store(pos, std::memory_order_relaxed);
+}
+
+/**
+ * FUNCTION NAME: ENwait
+ *
+ * DESCRIPTION: Collect what reaches this node until deadline, in ENclock time.
+ * 				Senders do not signal the ring, so look at it every SHM_POLL_USEC.
+ */
+void ShmNet::ENwait(Address *myaddr, long long deadline) {
+	while ( 1 ) {
+		{
+			lock_guard<recursive_mutex> guard(netLock);
+			collect(myaddr);
+		}
+
+		long long left = deadline - ENclock();
+		if ( left <= 0 ) {
+			break;
+		}
+		usleep(left < SHM_POLL_USEC ? left : SHM_POLL_USEC);
+	}
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Cleanup the emulnet and add the ring counters to the stats
+ */
+int ShmNet::ENcleanup() {
+	EmulNet::ENcleanup();
+
+	FILE *file = fopen(NETSTATS_LOG, "a");
+	if ( file ) {
+		fprintf(file, "shm ring_full %lu no_ring %lu bad_slots %lu rings %d\n", ringFullDrops, noRingDrops, badSlots, (int)rings.size());
+		fclose(file);
+	}
+	return 0;
+}
@@ -0,0 +1,106 @@
+/**********************************
+ * FILE NAME: ShmNet.h
+ *
+ * DESCRIPTION: Header file of the shared-memory ring transport
+ **********************************/
+
+#ifndef _SHMNET_H_
+#define _SHMNET_H_
+
+#include "stdincludes.h"
+#include "EmulNet.h"
+#include <atomic>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Macros
+ */
+// Slots in the ring of every node (power of two)
+#define SHM_RING_SLOTS 256
+// Slot stride is rounded up to this, one cache line
+#define SHM_ALIGN 64
+// Prefix of the shared memory object names, completed by the port of the node
+#define SHM_PREFIX "/emulnet."
+// Pause between two looks at the ring while a node waits for its next tick
+#define SHM_POLL_USEC 50
+
+/**
+ * Struct Name: shm_slot
+ *
+ * DESCRIPTION: One message slot of a ring; the payload follows it.
+ * 				seq tells producers and the consumer whose turn the slot is.
+ */
+typedef struct shm_slot {
+	std::atomic<unsigned long> seq;
+	int size;
+	int channel;
+	Address from;
+	Address to;
+}shm_slot;
+
+/**
+ * Struct Name: shm_ring
+ *
+ * DESCRIPTION: Header of the ring a node receives on, at the start of its
+ * 				shared memory object; the slots follow it
+ */
+typedef struct shm_ring {
+	unsigned long slots;
+	unsigned long stride;
+	// Generation of the run that set the ring up, written once it is ready
+	std::atomic<long> owner;
+	// Next position to claim, shared by all producers
+	alignas(SHM_ALIGN) std::atomic<unsigned long> enqueuePos;
+	// Next position to read, owned by the receiving node
+	alignas(SHM_ALIGN) std::atomic<unsigned long> dequeuePos;
+}shm_ring;
+
+/**
+ * CLASS NAME: ShmNet
+ *
+ * DESCRIPTION: EmulNet that moves messages through shared memory. Every node
+ * 				id owns a bounded multi-producer single-consumer ring in a
+ * 				shm_open'ed object named after its port (basePort + id), and
+ * 				senders copy the message straight into a slot of the ring of
+ * 				the receiver, with no system call on the message path. A node
+ * 				drains its own ring in ENrecvBatch. A full ring drops the message.
+ * 				The rings only hold plain data, so processes that map the same
+ * 				objects can exchange messages the same way: with ENsolo a
+ * 				process creates the ring of its node only and opens the others,
+ * 				accepting only rings stamped with the generation of this run.
+ */
+class ShmNet: public EmulNet {
+private:
+	short basePort;
+	// Generation of this run, shared by all its processes
+	long generation;
+	// Slot stride and size of the shared memory object of a ring
+	unsigned long stride;
+	size_t length;
+	// Ring of every node id, NULL until first used
+	vector<shm_ring *> rings;
+	// Shared memory objects created here, unlinked at cleanup
+	vector<string> created;
+	// Number of messages dropped because the ring of the receiver was full
+	unsigned long ringFullDrops;
+	// Number of messages dropped because the receiver had no ring of this run yet
+	unsigned long noRingDrops;
+	// Number of slots dropped by the receiver because their header made no sense
+	unsigned long badSlots;
+	shm_ring *getRing(Address *addr);
+	shm_ring *createRing(const char *name);
+	shm_ring *openRing(const char *name);
+	shm_slot *getSlot(shm_ring *ring, unsigned long pos);
+protected:
+	void transmit(en_msg *em);
+	void collect(Address *addr);
+public:
+	ShmNet(Params *p, short basePort, long generation);
+	virtual ~ShmNet();
+	void *ENinit(Address *myaddr, short port);
+	void ENwait(Address *myaddr, long long deadline);
+	int ENcleanup();
+};
+
+#endif /* _SHMNET_H_ */
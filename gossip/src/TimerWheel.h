@@ -0,0 +1,229 @@
+/**********************************
+ * FILE NAME: TimerWheel.h
+ *
+ * DESCRIPTION: Header file of the hierarchical timer wheel
+ **********************************/
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Slots of the inner wheel, one tick each (power of two)
+#define WHEEL_INNER_BITS 8
+// Slots of the outer wheel, one inner revolution each (power of two)
+#define WHEEL_OUTER_BITS 6
+#define WHEEL_INNER_SLOTS (1 << WHEEL_INNER_BITS)
+#define WHEEL_OUTER_SLOTS (1 << WHEEL_OUTER_BITS)
+
+/**
+ * CLASS NAME: TimerWheel
+ *
+ * DESCRIPTION: Two-level hierarchical timer wheel keyed on the global time in ticks.
+ * 				Items due within the current inner revolution sit in a one-tick
+ * 				slot, items due within the current outer revolution sit in the
+ * 				outer slot of their inner revolution and cascade down when it
+ * 				comes around, anything further out waits in an overflow list.
+ * 				Scheduling is O(1) and advancing costs O(ticks + items due).
+ */
+template <class T>
+class TimerWheel {
+private:
+	typedef pair<int, T> timer;
+	vector<timer> inner[WHEEL_INNER_SLOTS];
+	vector<timer> outer[WHEEL_OUTER_SLOTS];
+	vector<timer> overflow;
+	// Items that were already due when scheduled
+	vector<timer> ready;
+	// Last tick the wheel was advanced to
+	int current;
+	// Number of items held
+	int count;
+
+	void place(timer &t) {
+		if ( t.first <= current ) {
+			ready.push_back(t);
+		}
+		else if ( (t.first >> WHEEL_INNER_BITS) == (current >> WHEEL_INNER_BITS) ) {
+			inner[t.first & (WHEEL_INNER_SLOTS - 1)].push_back(t);
+		}
+		else if ( (t.first >> (WHEEL_INNER_BITS + WHEEL_OUTER_BITS)) == (current >> (WHEEL_INNER_BITS + WHEEL_OUTER_BITS)) ) {
+			outer[(t.first >> WHEEL_INNER_BITS) & (WHEEL_OUTER_SLOTS - 1)].push_back(t);
+		}
+		else {
+			overflow.push_back(t);
+		}
+	}
+
+	void cascade(vector<timer> &slot) {
+		vector<timer> items;
+		items.swap(slot);
+		for ( unsigned int i = 0; i < items.size(); i++ ) {
+			place(items[i]);
+		}
+	}
+
+public:
+	TimerWheel(): current(0), count(0) {}
+	virtual ~TimerWheel() {}
+
+	/**
+	 * FUNCTION NAME: schedule
+	 *
+	 * DESCRIPTION: Hold item until tick due
+	 */
+	void schedule(int due, T item) {
+		timer t(due, item);
+		place(t);
+		count++;
+	}
+
+	/**
+	 * FUNCTION NAME: advance
+	 *
+	 * DESCRIPTION: Move the wheel forward to tick time and append every item
+	 * 				due by then to out, in order of due tick
+	 */
+	void advance(int time, vector<T> &out) {
+		unsigned int i;
+
+		for ( i = 0; i < ready.size(); i++ ) {
+			out.push_back(ready[i].second);
+		}
+		count -= ready.size();
+		ready.clear();
+
+		while ( current < time && count > 0 ) {
+			current++;
+			if ( (current & (WHEEL_INNER_SLOTS - 1)) == 0 ) {
+				if ( ((current >> WHEEL_INNER_BITS) & (WHEEL_OUTER_SLOTS - 1)) == 0 ) {
+					cascade(overflow);
+				}
+				cascade(outer[(current >> WHEEL_INNER_BITS) & (WHEEL_OUTER_SLOTS - 1)]);
+			}
+
+			vector<timer> &slot = inner[current & (WHEEL_INNER_SLOTS - 1)];
+			for ( i = 0; i < slot.size(); i++ ) {
+				out.push_back(slot[i].second);
+			}
+			count -= slot.size();
+			// give the buffer back, or every slot keeps the capacity of its busiest tick
+			vector<timer>().swap(slot);
+
+			// cascading can put items that are due right now into ready
+			for ( i = 0; i < ready.size(); i++ ) {
+				out.push_back(ready[i].second);
+			}
+			count -= ready.size();
+			ready.clear();
+		}
+		if ( current < time ) {
+			// nothing left to wait for, jump ahead
+			current = time;
+		}
+	}
+
+	/**
+	 * FUNCTION NAME: drain
+	 *
+	 * DESCRIPTION: Remove every item still held, due or not
+	 */
+	void drain(vector<T> &out) {
+		unsigned int i, j;
+
+		for ( i = 0; i < WHEEL_INNER_SLOTS; i++ ) {
+			for ( j = 0; j < inner[i].size(); j++ ) {
+				out.push_back(inner[i][j].second);
+			}
+			inner[i].clear();
+		}
+		for ( i = 0; i < WHEEL_OUTER_SLOTS; i++ ) {
+			for ( j = 0; j < outer[i].size(); j++ ) {
+				out.push_back(outer[i][j].second);
+			}
+			outer[i].clear();
+		}
+		for ( j = 0; j < overflow.size(); j++ ) {
+			out.push_back(overflow[j].second);
+		}
+		overflow.clear();
+		for ( j = 0; j < ready.size(); j++ ) {
+			out.push_back(ready[j].second);
+		}
+		ready.clear();
+		count = 0;
+	}
+
+	/**
+	 * FUNCTION NAME: nextDue
+	 *
+	 * DESCRIPTION: Earliest tick an item is due at, without moving the wheel
+	 *
+	 * RETURNS:
+	 * -1 if the wheel is empty
+	 */
+	int nextDue() {
+		int next = -1;
+		int t;
+		unsigned int i;
+
+		if ( count == 0 ) {
+			return -1;
+		}
+		if ( !ready.empty() ) {
+			return current;
+		}
+		for ( t = current + 1; (t >> WHEEL_INNER_BITS) == (current >> WHEEL_INNER_BITS); t++ ) {
+			if ( !inner[t & (WHEEL_INNER_SLOTS - 1)].empty() ) {
+				return t;
+			}
+		}
+		// outer slots hold one inner revolution each, unordered within the slot
+		for ( t = (current >> WHEEL_INNER_BITS) + 1; (t >> WHEEL_OUTER_BITS) == (current >> (WHEEL_INNER_BITS + WHEEL_OUTER_BITS)); t++ ) {
+			vector<timer> &slot = outer[t & (WHEEL_OUTER_SLOTS - 1)];
+			for ( i = 0; i < slot.size(); i++ ) {
+				if ( next < 0 || slot[i].first < next ) {
+					next = slot[i].first;
+				}
+			}
+			if ( next >= 0 ) {
+				return next;
+			}
+		}
+		for ( i = 0; i < overflow.size(); i++ ) {
+			if ( next < 0 || overflow[i].first < next ) {
+				next = overflow[i].first;
+			}
+		}
+		return next;
+	}
+
+	/**
+	 * FUNCTION NAME: list
+	 *
+	 * DESCRIPTION: Append every item held, with the tick it is due at, to out.
+	 * 				Nothing is removed; scheduling them on a fresh wheel gives
+	 * 				the same deliveries, which is how a checkpoint restores one.
+	 */
+	void list(vector< pair<int, T> > &out) {
+		unsigned int i;
+
+		for ( i = 0; i < WHEEL_INNER_SLOTS; i++ ) {
+			out.insert(out.end(), inner[i].begin(), inner[i].end());
+		}
+		for ( i = 0; i < WHEEL_OUTER_SLOTS; i++ ) {
+			out.insert(out.end(), outer[i].begin(), outer[i].end());
+		}
+		out.insert(out.end(), overflow.begin(), overflow.end());
+		out.insert(out.end(), ready.begin(), ready.end());
+	}
+
+	int size() {
+		return count;
+	}
+};
+
+#endif /* TIMERWHEEL_H_ */
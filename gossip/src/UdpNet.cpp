@@ -0,0 +1,332 @@
+/**********************************
+ * FILE NAME: UdpNet.cpp
+ *
+ * DESCRIPTION: Definition of the loopback UDP transport
+ **********************************/
+
+#include "UdpNet.h"
+
+/**
+ * Constructor
+ */
+UdpNet::UdpNet(Params *p, short basePort): EmulNet(p), basePort(basePort), sendBusy(0), sendErrors(0) {
+	epfd = epoll_create1(0);
+	timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	if ( epfd < 0 || timerfd < 0 ) {
+		perror("epoll_create1");
+		exit(1);
+	}
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = UDP_TIMER_TAG;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, timerfd, &ev);
+}
+
+/**
+ * Destructor
+ */
+UdpNet::~UdpNet() {
+	for ( unsigned int i = 0; i < sockets.size(); i++ ) {
+		if ( sockets[i] >= 0 ) {
+			close(sockets[i]);
+		}
+	}
+	close(timerfd);
+	close(epfd);
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Init the emulnet for this node and open its socket
+ */
+void *UdpNet::ENinit(Address *myaddr, short port) {
+	EmulNet::ENinit(myaddr, port);
+	getSocket(myaddr);
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: getSocket
+ *
+ * DESCRIPTION: Return the socket of node id, opening it and binding it to
+ * 				127.0.0.1 at port (basePort + id if port is 0) on first use
+ *
+ * RETURNS:
+ * -1 if the socket cannot be opened
+ */
+int UdpNet::getSocket(int id, short port) {
+	if ( id < 0 ) {
+		return -1;
+	}
+	if ( id >= (int)sockets.size() ) {
+		sockets.resize(id + 1, -1);
+		rcvbufDrops.resize(id + 1, 0);
+	}
+	if ( sockets[id] >= 0 ) {
+		return sockets[id];
+	}
+
+	int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if ( fd < 0 ) {
+		perror("socket");
+		return -1;
+	}
+
+	int rcvbuf = UDP_RCVBUF;
+	int one = 1;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	// have every datagram carry the number of datagrams the socket dropped so far
+	setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+
+	struct sockaddr_in sin;
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = htons(port ? port : (unsigned short)(basePort + id));
+	if ( bind(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0 ) {
+		perror("bind");
+		close(fd);
+		return -1;
+	}
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = id;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+
+	sockets[id] = fd;
+	return fd;
+}
+
+/**
+ * FUNCTION NAME: getSocket
+ *
+ * DESCRIPTION: Return the socket of the node with the given address
+ */
+int UdpNet::getSocket(Address *addr) {
+	return getSocket(*(int *)(addr->addr), *(short *)(&addr->addr[4]));
+}
+
+/**
+ * FUNCTION NAME: ENmaxSize
+ *
+ * DESCRIPTION: Largest message that fits MAX_MSG_SIZE and one datagram
+ */
+int UdpNet::ENmaxSize() {
+	int datagram = UDP_MAXDATAGRAM - UDP_HDRSIZE;
+	int emulated = EmulNet::ENmaxSize();
+
+	return emulated < datagram ? emulated : datagram;
+}
+
+/**
+ * FUNCTION NAME: transmit
+ *
+ * DESCRIPTION: Send the message as one datagram from the socket of the sender
+ * 				to the socket of the receiver. The envelope and the buffer are
+ * 				given back right away; the kernel holds the copy in flight.
+ */
+void UdpNet::transmit(en_msg *em) {
+	int src = getSocket(&em->from);
+	if ( soloId < 0 ) {
+		// All nodes live in this process, so open the receiving end too in case
+		// it has not been used yet and the datagram would hit a closed port
+		getSocket(&em->to);
+	}
+
+	struct sockaddr_in sin;
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	short port = *(short *)(&em->to.addr[4]);
+	sin.sin_port = htons(port ? port : (unsigned short)(basePort + *(int *)(em->to.addr)));
+
+	struct iovec iov[4];
+	iov[0].iov_base = &em->from;
+	iov[0].iov_len = sizeof(Address);
+	iov[1].iov_base = &em->to;
+	iov[1].iov_len = sizeof(Address);
+	iov[2].iov_base = &em->channel;
+	iov[2].iov_len = sizeof(int);
+	iov[3].iov_base = em->data;
+	iov[3].iov_len = em->size;
+
+	struct msghdr mh;
+	memset(&mh, 0, sizeof(mh));
+	mh.msg_name = &sin;
+	mh.msg_namelen = sizeof(sin);
+	mh.msg_iov = iov;
+	mh.msg_iovlen = 4;
+
+	if ( src < 0 ) {
+		sendErrors++;
+	}
+	else if ( sendmsg(src, &mh, 0) < 0 ) {
+		if ( errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ) {
+			sendBusy++;
+		}
+		else if ( errno == EMSGSIZE ) {
+			oversizeDrops++;
+		}
+		else {
+			sendErrors++;
+		}
+	}
+	else {
+		// the datagram waits in the socket until its node collects it
+		markReady(*(int *)(em->to.addr));
+	}
+
+	ENfree(em->data);
+	pool.release(em);
+}
+
+/**
+ * FUNCTION NAME: drain
+ *
+ * DESCRIPTION: Move every datagram waiting on the socket of node id into its mailbox
+ */
+void UdpNet::drain(int id) {
+	int fd = sockets[id];
+
+	while ( 1 ) {
+		char hdr[UDP_HDRSIZE];
+		// With MSG_TRUNC the kernel reports the full length of the datagram
+		ssize_t len = recv(fd, hdr, sizeof(hdr), MSG_PEEK | MSG_TRUNC);
+		if ( len < 0 ) {
+			break;
+		}
+		if ( len < (ssize_t)UDP_HDRSIZE ) {
+			// not one of ours, throw it away
+			recv(fd, hdr, sizeof(hdr), 0);
+			continue;
+		}
+
+		en_msg *em = (en_msg *) pool.allocate(sizeof(en_msg));
+		em->size = len - UDP_HDRSIZE;
+		em->data = ENalloc(em->size);
+
+		struct iovec iov[4];
+		iov[0].iov_base = &em->from;
+		iov[0].iov_len = sizeof(Address);
+		iov[1].iov_base = &em->to;
+		iov[1].iov_len = sizeof(Address);
+		iov[2].iov_base = &em->channel;
+		iov[2].iov_len = sizeof(int);
+		iov[3].iov_base = em->data;
+		iov[3].iov_len = em->size;
+
+		char control[CMSG_SPACE(sizeof(unsigned int))];
+		struct msghdr mh;
+		memset(&mh, 0, sizeof(mh));
+		mh.msg_iov = iov;
+		mh.msg_iovlen = 4;
+		mh.msg_control = control;
+		mh.msg_controllen = sizeof(control);
+
+		if ( recvmsg(fd, &mh, 0) < 0 ) {
+			ENfree(em->data);
+			pool.release(em);
+			break;
+		}
+		for ( struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mh); cmsg != NULL; cmsg = CMSG_NXTHDR(&mh, cmsg) ) {
+			if ( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL ) {
+				memcpy(&rcvbufDrops[id], CMSG_DATA(cmsg), sizeof(unsigned int));
+			}
+		}
+		if ( em->channel < 0 || em->channel >= EN_CHANNELS ) {
+			// not one of ours either
+			ENfree(em->data);
+			pool.release(em);
+			continue;
+		}
+		park(em, par->getcurrtime());
+	}
+}
+
+/**
+ * FUNCTION NAME: collect
+ *
+ * DESCRIPTION: Drain every socket epoll reports as readable, without blocking
+ */
+void UdpNet::collect(Address *addr) {
+	struct epoll_event events[UDP_MAXEVENTS];
+	int n;
+
+	getSocket(addr);
+	do {
+		n = epoll_wait(epfd, events, UDP_MAXEVENTS, 0);
+		for ( int i = 0; i < n; i++ ) {
+			if ( events[i].data.u32 != UDP_TIMER_TAG ) {
+				drain(events[i].data.u32);
+			}
+		}
+	} while ( n == UDP_MAXEVENTS );
+}
+
+/**
+ * FUNCTION NAME: ENwait
+ *
+ * DESCRIPTION: Sleep in epoll until deadline, in ENclock time, moving datagrams
+ * 				into the mailboxes as they come in so the socket buffers do not
+ * 				fill up while the node is idle
+ */
+void UdpNet::ENwait(Address *myaddr, long long deadline) {
+	lock_guard<recursive_mutex> guard(netLock);
+	struct epoll_event events[UDP_MAXEVENTS];
+	struct itimerspec its;
+	unsigned long long expirations;
+	bool due = false;
+
+	memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = deadline / 1000000;
+	its.it_value.tv_nsec = deadline % 1000000 * 1000;
+	if ( its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0 ) {
+		// a zero it_value would disarm the timer
+		its.it_value.tv_nsec = 1;
+	}
+	timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &its, NULL);
+
+	getSocket(myaddr);
+	while ( !due ) {
+		int n = epoll_wait(epfd, events, UDP_MAXEVENTS, -1);
+		if ( n < 0 && errno != EINTR ) {
+			perror("epoll_wait");
+			break;
+		}
+		for ( int i = 0; i < n; i++ ) {
+			if ( events[i].data.u32 == UDP_TIMER_TAG ) {
+				due = read(timerfd, &expirations, sizeof(expirations)) > 0;
+			}
+			else {
+				drain(events[i].data.u32);
+			}
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Cleanup the emulnet and add the socket counters to the stats
+ */
+int UdpNet::ENcleanup() {
+	EmulNet::ENcleanup();
+
+	FILE *file = fopen(NETSTATS_LOG, "a");
+	if ( file ) {
+		unsigned long drops = 0;
+		int open = 0;
+		for ( unsigned int i = 0; i < sockets.size(); i++ ) {
+			drops += rcvbufDrops[i];
+			open += sockets[i] >= 0;
+		}
+		fprintf(file, "udp send_busy %lu send_errors %lu rcvbuf_drops %lu sockets %d\n", sendBusy, sendErrors, drops, open);
+		fclose(file);
+	}
+	return 0;
+}
@@ -34,11 +34,11 @@ int main(int argc, char *argv[]) {
 	// Create a new application object
 	Application *app = new Application(argv[1]);
 	// Call the run function
-	app->run();
+	int status = app->run();
 	// When done delete the application object
 	delete(app);
 
-	return SUCCESS;
+	return status;
 }
 
 /**
@@ -47,13 +47,26 @@ int main(int argc, char *argv[]) {
 Application::Application(char *infile) {
 	int i;
 	par = new Params();
-	srand (time(NULL));
 	par->setparams(infile);
+	srand (par->SEED ? par->SEED : time(NULL));
 	log = new Log(par);
-	en = new EmulNet(par);
-	en1 = new EmulNet(par);
-	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
-	mp2 = (MP2Node **) malloc(par->EN_GPSZ * sizeof(MP2Node *));
+	exec = new Executor(par->THREADS);
+	workload = ( WORKLOAD_TEST == par->CRUDTEST ) ? new Workload(par, rand()) : NULL;
+	// Both layers share one network; every message carries the channel of its layer
+	if ( par->TRANSPORT == UDP_TRANSPORT ) {
+		en = new UdpNet(par, par->PORTNUM);
+	}
+	else if ( par->TRANSPORT == SHM_TRANSPORT ) {
+		en = new ShmNet(par, par->PORTNUM, getpid());
+	}
+	else {
+		en = new EmulNet(par);
+	}
+	mp1.resize(par->EN_GPSZ);
+	mp2.resize(par->EN_GPSZ);
+	loopAt.assign(par->EN_GPSZ, -1);
+	timeWhenAllNodesHaveJoined = 0;
+	allNodesJoined = false;
 
 	/*
 	 * Init all nodes
@@ -66,26 +79,62 @@ Application::Application(char *infile) {
 		joinaddr = getjoinaddr();
 		addressOfMemberNode = (Address *) en->ENinit(addressOfMemberNode, par->PORTNUM);
 		mp1[i] = new MP1Node(memberNode, par, en, log, addressOfMemberNode);
-		mp2[i] = new MP2Node(memberNode, par, en1, log, addressOfMemberNode);
+		mp2[i] = new MP2Node(memberNode, par, en, log, addressOfMemberNode);
 		log->LOG(&(mp1[i]->getMemberNode()->addr), "APP");
 		log->LOG(&(mp2[i]->getMemberNode()->addr), "APP MP2");
 		delete addressOfMemberNode;
 	}
+
+	if ( par->BOOTSTRAP ) {
+		bootstrap();
+		return;
+	}
+
+	/*
+	 * Node i is introduced at STEP_RATE * i
+	 */
+	for( i = 0; i < par->EN_GPSZ; i++ ) {
+		schedule((int)(par->STEP_RATE*i), i, NODE_START);
+	}
+}
+
+/**
+ * FUNCTION NAME: bootstrap
+ *
+ * DESCRIPTION: Put every node in the group at once with the converged membership
+ * 				list, skipping the joins through the introducer, and have all of
+ * 				them loop from the first tick on
+ */
+void Application::bootstrap() {
+	vector<MemberListEntry> members;
+	int i;
+
+	members.reserve(par->EN_GPSZ);
+	for ( i = 0; i < par->EN_GPSZ; i++ ) {
+		Address *addr = &mp1[i]->getMemberNode()->addr;
+		members.push_back(MemberListEntry(*(int *)(&addr->addr), *(short *)(&addr->addr[4]), 0, par->getcurrtime()));
+	}
+	for ( i = 0; i < par->EN_GPSZ; i++ ) {
+		mp1[i]->bootstrap(members);
+		nodeCount += i;
+		loopAt[i] = par->getcurrtime();
+		schedule(par->getcurrtime(), i, NODE_LOOP);
+	}
+	cout<<par->EN_GPSZ<<" nodes bootstrapped into the group"<<endl;
 }
 
 /**
  * Destructor
  */
 Application::~Application() {
+	delete exec;
+	delete workload;
 	delete log;
 	delete en;
-	delete en1;
 	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
 		delete mp1[i];
 		delete mp2[i];
 	}
-	free(mp1);
-	free(mp2);
 	delete par;
 }
 
@@ -97,13 +146,22 @@ Application::~Application() {
 int Application::run()
 {
 	int i;
-	int timeWhenAllNodesHaveJoined = 0;
-	// boolean indicating if all nodes have joined
-	bool allNodesJoined = false;
-	srand(time(NULL));
+	int saveTime = par->CHECKPOINT_TIME >= 0 ? par->CHECKPOINT_TIME : INSERT_TIME;
+	srand(par->SEED ? par->SEED : time(NULL));
+
+	// Pick up where an earlier run saved the simulation
+	if ( par->CHECKPOINT_LOAD[0] && !checkpoint(par->CHECKPOINT_LOAD, false) ) {
+		cout<<"Could not restore the checkpoint "<<par->CHECKPOINT_LOAD<<endl;
+		return FAILURE;
+	}
 
 	// As time runs along
-	for( par->globaltime = 0; par->globaltime < TOTAL_RUNNING_TIME; ++par->globaltime ) {
+	for( ; par->globaltime < par->TOTAL_RUNNING_TIME; ++par->globaltime ) {
+		// Save the simulation before anything happens in this tick
+		if ( par->CHECKPOINT_SAVE[0] && par->getcurrtime() == saveTime && !checkpoint(par->CHECKPOINT_SAVE, true) ) {
+			cout<<"Could not save the checkpoint "<<par->CHECKPOINT_SAVE<<endl;
+		}
+
 		// Run the membership protocol
 		mp1Run();
 
@@ -112,17 +170,36 @@ int Application::run()
 			timeWhenAllNodesHaveJoined = par->getcurrtime();
 			allNodesJoined = true;
 		}
-		if ( par->getcurrtime() > timeWhenAllNodesHaveJoined + 50 ) {
+		if ( par->getcurrtime() > timeWhenAllNodesHaveJoined + (par->BOOTSTRAP ? 0 : CONVERGE_TIME) ) {
 			// Call the KV store functionalities
 			mp2Run();
 		}
+		// Loop the nodes again at their next deadline, now that the operations they
+		// coordinate in this tick are open
+		for ( unsigned int k = 0; k < looping.size(); k++ ) {
+			scheduleLoop(looping[k]);
+		}
 		// Fail some nodes
 		//fail();
 	}
 
 	// Clean up
 	en->ENcleanup();
-	en1->ENcleanup();
+
+	// How balanced the per-node phases were
+	FILE *file = fopen(EXECSTATS_LOG, "w+");
+	exec->printStats(file);
+	fclose(file);
+
+	if ( workload ) {
+		file = fopen(WORKLOAD_LOG, "w+");
+		workload->printStats(file);
+		fclose(file);
+	}
+
+	file = fopen(LATENCY_LOG, "w+");
+	printLatency(file);
+	fclose(file);
 
 	for(i=0;i<=par->EN_GPSZ-1;i++) {
 		 mp1[i]->finishUpThisNode();
@@ -131,44 +208,231 @@ int Application::run()
 	return SUCCESS;
 }
 
+/**
+ * FUNCTION NAME: printLatency
+ *
+ * DESCRIPTION: Merge the latency histograms of all the coordinators and print, per
+ * 				operation type, the percentiles from client call to quorum in ticks,
+ * 				the failures and the completion rate
+ */
+void Application::printLatency(FILE *file) {
+	static const char *names[] = {"create", "read", "update", "delete"};
+	Histogram all[DELETE + 1];
+	Histogram total;
+	unsigned long failed[DELETE + 1] = {0};
+	unsigned long totalFailed = 0;
+	int firstStart = -1, lastEnd = -1;
+	int i, type;
+
+	for ( i = 0; i < par->EN_GPSZ; i++ ) {
+		for ( type = CREATE; type <= DELETE; type++ ) {
+			all[type].add(mp2[i]->getLatency((MessageType)type));
+			failed[type] += mp2[i]->getFailed((MessageType)type);
+		}
+		if ( mp2[i]->getFirstStart() >= 0 && (firstStart < 0 || mp2[i]->getFirstStart() < firstStart) ) {
+			firstStart = mp2[i]->getFirstStart();
+		}
+		if ( mp2[i]->getLastEnd() > lastEnd ) {
+			lastEnd = mp2[i]->getLastEnd();
+		}
+	}
+
+	for ( type = CREATE; type <= DELETE; type++ ) {
+		Histogram &h = all[type];
+		fprintf(file, "%s ops %lu failed %lu p50 %lu p99 %lu p999 %lu max %lu mean %.3f\n", names[type], h.getCount(), failed[type], h.valueAt(50), h.valueAt(99), h.valueAt(99.9), h.getMax(), h.getMean());
+		total.add(h);
+		totalFailed += failed[type];
+	}
+	fprintf(file, "total ops %lu failed %lu p50 %lu p99 %lu p999 %lu max %lu mean %.3f\n", total.getCount(), totalFailed, total.valueAt(50), total.valueAt(99), total.valueAt(99.9), total.getMax(), total.getMean());
+	fprintf(file, "throughput %.3f ops/tick over ticks %d to %d\n", firstStart >= 0 && lastEnd >= firstStart ? (double)(total.getCount() - totalFailed) / (lastEnd - firstStart + 1) : 0.0, firstStart, lastEnd);
+}
+
+/**
+ * FUNCTION NAME: checkpoint
+ *
+ * DESCRIPTION: Save the simulation to file at the start of the current tick, or
+ * 				restore it from file into the nodes just set up by the constructor,
+ * 				so that the run goes on from the tick it was saved at
+ *
+ * RETURNS:
+ * false if the file could not be written or does not fit this run
+ */
+bool Application::checkpoint(const char *file, bool save) {
+	Checkpoint cp;
+
+	if ( par->TRANSPORT != EMUL_TRANSPORT ) {
+		// the sockets and rings of the other transports hold messages we cannot get at
+		return false;
+	}
+	if ( save ? !cp.save(file) : !cp.restore(file) ) {
+		return false;
+	}
+	if ( !checkpoint(cp) ) {
+		return false;
+	}
+	if ( !cp.close() ) {
+		return false;
+	}
+	cout<<endl<<(save ? "Saved" : "Restored")<<" the checkpoint "<<file<<" at time: "<<par->getcurrtime()<<endl;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: checkpoint
+ *
+ * DESCRIPTION: Save or restore the whole simulation: the clock, the pending node
+ * 				events, both networks with their messages in flight, every node's
+ * 				membership, ring, hash table and open operations, the test keys
+ * 				and the workload. The test case parameters come from the
+ * 				configuration of the run, only the number of nodes has to match.
+ * 				The shared random number generator cannot be saved, so saving
+ * 				reseeds it from itself and restoring reseeds it the same way;
+ * 				a restored run then goes on exactly like the run that saved it.
+ */
+bool Application::checkpoint(Checkpoint &cp) {
+	int nodes = par->EN_GPSZ;
+	bool hasWorkload = workload != NULL;
+	unsigned int reseed = cp.saving() ? rand() : 0;
+	vector< pair<int, app_event> > pending;
+	vector<app_event> stale;
+	unsigned int k;
+
+	cp.io(nodes);
+	cp.io(hasWorkload);
+	if ( !cp.ok() || nodes != par->EN_GPSZ || hasWorkload != (workload != NULL) ) {
+		return false;
+	}
+
+	cp.io(par->globaltime);
+	cp.io(par->dropmsg);
+	cp.io(par->allNodesJoined);
+	cp.io(nodeCount);
+	cp.io(timeWhenAllNodesHaveJoined);
+	cp.io(allNodesJoined);
+	cp.io(reseed);
+	srand(reseed);
+
+	if ( cp.saving() ) {
+		events.list(pending);
+	}
+	else {
+		// the node starts the constructor scheduled are in the checkpoint if still due
+		events.drain(stale);
+	}
+	cp.io(pending);
+	if ( !cp.saving() ) {
+		for ( k = 0; k < pending.size(); k++ ) {
+			events.schedule(pending[k].first, pending[k].second);
+		}
+	}
+	cp.io(held);
+	cp.io(loopAt);
+	cp.io(testKVPairs);
+
+	en->ENcheckpoint(cp);
+	for ( int i = 0; i < par->EN_GPSZ && cp.ok(); i++ ) {
+		mp1[i]->checkpoint(cp);
+		mp2[i]->checkpoint(cp);
+	}
+	MP2Node::checkpointShared(cp);
+	if ( workload ) {
+		workload->checkpoint(cp);
+	}
+
+	return cp.ok();
+}
+
 /**
  * FUNCTION NAME: mp1Run
  *
  * DESCRIPTION:	This function performs all the membership protocol functionalities
  */
 void Application::mp1Run() {
+	unsigned int k;
 	int i;
+	vector<int> ready;
+	vector<int> receivers;
+	vector<app_event> due;
+	vector<app_event> nodes;
 
-	// For all the nodes in the system
-	for( i = 0; i <= par->EN_GPSZ-1; i++) {
+	/*
+	 * Only the nodes the network has delivered messages to have anything to receive
+	 */
+	en->ENready(ready);
+	ready.insert(ready.end(), held.begin(), held.end());
+	held.clear();
+	for( k = 0; k < ready.size(); k++ ) {
+		i = ready[k] - 1;
+		if( i < 0 || i >= par->EN_GPSZ || mp1[i]->getMemberNode()->bFailed ) {
+			continue;
+		}
+		// nodes start after the receive phase of their tick, so messages wait until then
+		if( mp1[i]->getMemberNode()->inited ) {
+			receivers.push_back(i);
+		}
+		else {
+			held.push_back(ready[k]);
+		}
+	}
+	sort(receivers.begin(), receivers.end());
+	receivers.erase(unique(receivers.begin(), receivers.end()), receivers.end());
+
+	// For the nodes with messages, in node order
+	runPhase(receivers.size(), [&](int task) {
 
 		/*
-		 * Receive messages from the network and queue them in the membership protocol queue
+		 * Receive messages from the network and queue them in the membership protocol
+		 * and KV store queues
 		 */
-		if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
-			// Receive messages from the network and queue them
-			mp1[i]->recvLoop();
-		}
+		mp2[receivers[task]]->recvLoop();
+
+	});
 
+	/*
+	 * Only the nodes with messages, or with a start or a loop due now, have work to do
+	 */
+	for( k = 0; k < receivers.size(); k++ ) {
+		i = receivers[k];
+		if( loopAt[i] != par->getcurrtime() ) {
+			app_event event;
+			event.node = i;
+			event.type = NODE_LOOP;
+			nodes.push_back(event);
+		}
+	}
+	events.advance(par->getcurrtime(), due);
+	for( k = 0; k < due.size(); k++ ) {
+		i = due[k].node;
+		if( i < 0 ) {
+			continue;
+		}
+		if( due[k].type == NODE_LOOP ) {
+			if( loopAt[i] != par->getcurrtime() || mp1[i]->getMemberNode()->bFailed ) {
+				// rescheduled since, or failed for good
+				continue;
+			}
+			loopAt[i] = -1;
+		}
+		nodes.push_back(due[k]);
 	}
+	sort(nodes.begin(), nodes.end(), [](const app_event &a, const app_event &b) { return a.node > b.node; });
 
-	// For all the nodes in the system
-	for( i = par->EN_GPSZ - 1; i >= 0; i-- ) {
+	// For the nodes with work due, from the last one down
+	runPhase(nodes.size(), [&](int task) {
+		int i = nodes[task].node;
 
 		/*
 		 * Introduce nodes into the distributed system
 		 */
-		if( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
+		if( nodes[task].type == NODE_START ) {
 			// introduce the ith node into the system at time STEPRATE*i
 			mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
-			cout<<i<<"-th introduced node is assigned with the address: "<<mp1[i]->getMemberNode()->addr.getAddress() << endl;
-			nodeCount += i;
 		}
 
 		/*
 		 * Handle all the messages in your queue and send heartbeats
 		 */
-		else if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
+		else {
 			// handle messages and send heartbeats
 			mp1[i]->nodeLoop();
 			#ifdef DEBUGLOG
@@ -178,6 +442,75 @@ void Application::mp1Run() {
 			#endif
 		}
 
+	});
+
+	// Announce the nodes introduced in this tick; the looping ones are scheduled again after the KV store ran
+	looping.clear();
+	for( k = 0; k < nodes.size(); k++ ) {
+		i = nodes[k].node;
+		if( nodes[k].type == NODE_LOOP ) {
+			looping.push_back(i);
+		}
+		if( nodes[k].type == NODE_START ) {
+			cout<<i<<"-th introduced node is assigned with the address: "<<mp1[i]->getMemberNode()->addr.getAddress() << endl;
+			nodeCount += i;
+			scheduleLoop(i);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: runPhase
+ *
+ * DESCRIPTION: Run task(0) ... task(tasks - 1) on the executor and wait for all of them.
+ * 				The messages and log lines of the tasks are staged and released in
+ * 				task order afterwards, so a run with a fixed SEED gives the same
+ * 				results with any number of THREADS.
+ */
+void Application::runPhase(int tasks, const function<void(int)> &task) {
+	if ( tasks == 0 ) {
+		return;
+	}
+	en->ENstage(tasks);
+	log->stage(tasks);
+	exec->run(tasks, task);
+	en->ENflush();
+	log->flush();
+}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Have the event of the given type run for node at tick time
+ */
+void Application::schedule(int time, int node, int type) {
+	app_event event;
+
+	event.node = node;
+	event.type = type;
+	events.schedule(time, event);
+}
+
+/**
+ * FUNCTION NAME: scheduleLoop
+ *
+ * DESCRIPTION: Have node i loop again at its next deadline, its next gossip round,
+ * 				member deadline or operation timeout, unless that loop is already
+ * 				scheduled; a node without one loops when messages arrive
+ */
+void Application::scheduleLoop(int i) {
+	int next = mp1[i]->nextLoop();
+	int timeout = mp2[i]->nextTimeout();
+
+	if ( timeout >= 0 && !mp1[i]->getMemberNode()->bFailed && (next < 0 || timeout < next) ) {
+		next = timeout > par->getcurrtime() ? timeout : par->getcurrtime() + 1;
+	}
+	if ( next == loopAt[i] ) {
+		return;
+	}
+	loopAt[i] = next;
+	if ( next >= 0 ) {
+		schedule(next, i, NODE_LOOP);
 	}
 }
 
@@ -190,41 +523,42 @@ void Application::mp1Run() {
  * 				2) CRUD operations
  */
 void Application::mp2Run() {
-	int i;
 
-	// For all the nodes in the system
-	for( i = 0; i <= par->EN_GPSZ-1; i++) {
+	int nodes = looping.size();
+
+	// For the nodes whose membership loop ran in this tick, in node order
+	runPhase(nodes, [&](int task) {
+		int i = looping[nodes - 1 - task];
 
 		/*
-		 * 1) Update the ring
-		 * 2) Receive messages from the network and queue them in the KV store queue
+		 * Update the ring; the messages of the KV store were queued by the receive phase
 		 */
-		if ( par->getcurrtime() > (int)(par->STEP_RATE*i) && !mp2[i]->getMemberNode()->bFailed ) {
-			if ( mp2[i]->getMemberNode()->inited && mp2[i]->getMemberNode()->inGroup ) {
-				// Step 1
-				mp2[i]->updateRing();
-			}
-			// Step 2
-			mp2[i]->recvLoop();
+		if ( mp2[i]->getMemberNode()->inited && mp2[i]->getMemberNode()->inGroup ) {
+			mp2[i]->updateRing();
 		}
-	}
+	});
 
 	/**
 	 * Handle messages from the queue and update the DHT
 	 */
-	for ( i = par->EN_GPSZ-1; i >= 0; i-- ) {
-		if ( par->getcurrtime() > (int)(par->STEP_RATE*i) && !mp2[i]->getMemberNode()->bFailed ) {
-			mp2[i]->checkMessages();
-		}
-	}
+	runPhase(nodes, [&](int task) {
+		mp2[looping[task]]->checkMessages();
+	});
 
 	/**
 	 * Insert a set of test key value pairs into the system
 	 */
-	if ( par->getcurrtime() == INSERT_TIME ) {
+	if ( par->getcurrtime() == INSERT_TIME && WORKLOAD_TEST != par->CRUDTEST ) {
 		insertTestKVPairs();
 	}
 
+	/**
+	 * Load the workload's keys and run its operation mix from then on
+	 */
+	if ( par->getcurrtime() >= INSERT_TIME && workload ) {
+		runWorkload();
+	}
+
 	/**
 	 * Test CRUD operations
 	 */
@@ -398,7 +732,7 @@ int Application::findARandomNodeThatIsAlive() {
  * DESCRIPTION: Init NUMBER_OF_INSERTS test KV pairs in the map
  */
 void Application::initTestKVPairs() {
-	srand(time(NULL));
+	srand(par->SEED ? par->SEED : time(NULL));
 	int i;
 	string key;
 	key.clear();
@@ -439,6 +773,38 @@ void Application::insertTestKVPairs() {
 	cout<<endl<<"Sent " <<testKVPairs.size() <<" create messages to the ring"<<endl;
 }
 
+/**
+ * FUNCTION NAME: runWorkload
+ *
+ * DESCRIPTION: Issue the workload operations due in this tick, each on a random live coordinator
+ */
+void Application::runWorkload() {
+	vector<wl_op> ops;
+	int number;
+
+	workload->tick(ops);
+	for ( unsigned int i = 0; i < ops.size(); i++ ) {
+		number = findARandomNodeThatIsAlive();
+		if ( par->DETAILED_LOGS ) {
+			log->LOG(&mp2[number]->getMemberNode()->addr, "WORKLOAD OPERATION %d KEY: %s at time: %d", ops[i].type, ops[i].key.c_str(), par->getcurrtime());
+		}
+		switch ( ops[i].type ) {
+			case CREATE:
+				mp2[number]->clientCreate(ops[i].key, ops[i].value);
+				break;
+			case READ:
+				mp2[number]->clientRead(ops[i].key);
+				break;
+			case UPDATE:
+				mp2[number]->clientUpdate(ops[i].key, ops[i].value);
+				break;
+			default:
+				mp2[number]->clientDelete(ops[i].key);
+				break;
+		}
+	}
+}
+
 /**
  * FUNCTION NAME: deleteTest
  *
@@ -525,7 +891,7 @@ void Application::readTest() {
 
 		// Step 2.c Fail a replica
 		for ( int i = 0; i < par->EN_GPSZ; i++ ) {
-			if ( mp2[i]->getMemberNode()->addr.getAddress() == replicas.at(replicaIdToFail).getAddress()->getAddress() ) {
+			if ( mp2[i]->getMemberNode()->addr == *replicas.at(replicaIdToFail).getAddress() ) {
 				if ( !mp2[i]->getMemberNode()->bFailed ) {
 					nodeToFail = i;
 					failedOneNode = true;
@@ -591,7 +957,7 @@ void Application::readTest() {
 				while ( count != 2 ) {
 					int i = 0;
 					while ( i != par->EN_GPSZ ) {
-						if ( mp2[i]->getMemberNode()->addr.getAddress() == replicas.at(replicaIdToFail).getAddress()->getAddress() ) {
+						if ( mp2[i]->getMemberNode()->addr == *replicas.at(replicaIdToFail).getAddress() ) {
 							if ( !mp2[i]->getMemberNode()->bFailed ) {
 								nodesToFail.emplace_back(i);
 								replicaIdToFail--;
@@ -668,9 +1034,9 @@ void Application::readTest() {
 		replicas = mp2[number]->findNodes(it->first);
 		for ( int i = 0; i < par->EN_GPSZ; i++ ) {
 			if ( !mp2[i]->getMemberNode()->bFailed ) {
-				if ( mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(PRIMARY).getAddress()->getAddress() &&
-					 mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(SECONDARY).getAddress()->getAddress() &&
-					 mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(TERTIARY).getAddress()->getAddress() ) {
+				if ( mp2[i]->getMemberNode()->addr != *replicas.at(PRIMARY).getAddress() &&
+					 mp2[i]->getMemberNode()->addr != *replicas.at(SECONDARY).getAddress() &&
+					 mp2[i]->getMemberNode()->addr != *replicas.at(TERTIARY).getAddress() ) {
 					// Step 4.c Fail a non-replica node
 					log->LOG(&mp2[i]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
 					mp2[i]->getMemberNode()->bFailed = true;
@@ -770,7 +1136,7 @@ void Application::updateTest() {
 
 		// Step 2.c Fail a replica
 		for ( int i = 0; i < par->EN_GPSZ; i++ ) {
-			if ( mp2[i]->getMemberNode()->addr.getAddress() == replicas.at(replicaIdToFail).getAddress()->getAddress() ) {
+			if ( mp2[i]->getMemberNode()->addr == *replicas.at(replicaIdToFail).getAddress() ) {
 				if ( !mp2[i]->getMemberNode()->bFailed ) {
 					nodeToFail = i;
 					failedOneNode = true;
@@ -835,7 +1201,7 @@ void Application::updateTest() {
 				while ( count != 2 ) {
 					int i = 0;
 					while ( i != par->EN_GPSZ ) {
-						if ( mp2[i]->getMemberNode()->addr.getAddress() == replicas.at(replicaIdToFail).getAddress()->getAddress() ) {
+						if ( mp2[i]->getMemberNode()->addr == *replicas.at(replicaIdToFail).getAddress() ) {
 							if ( !mp2[i]->getMemberNode()->bFailed ) {
 								nodesToFail.emplace_back(i);
 								replicaIdToFail--;
@@ -910,9 +1276,9 @@ void Application::updateTest() {
 		replicas = mp2[number]->findNodes(it->first);
 		for ( int i = 0; i < par->EN_GPSZ; i++ ) {
 			if ( !mp2[i]->getMemberNode()->bFailed ) {
-				if ( mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(PRIMARY).getAddress()->getAddress() &&
-					 mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(SECONDARY).getAddress()->getAddress() &&
-					 mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(TERTIARY).getAddress()->getAddress() ) {
+				if ( mp2[i]->getMemberNode()->addr != *replicas.at(PRIMARY).getAddress() &&
+					 mp2[i]->getMemberNode()->addr != *replicas.at(SECONDARY).getAddress() &&
+					 mp2[i]->getMemberNode()->addr != *replicas.at(TERTIARY).getAddress() ) {
 					// Step 4.c Fail a non-replica node
 					log->LOG(&mp2[i]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
 					mp2[i]->getMemberNode()->bFailed = true;
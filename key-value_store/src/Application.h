@@ -13,10 +13,14 @@
 #include "Params.h"
 #include "Member.h"
 #include "EmulNet.h"
-#include "Queue.h"
+#include "UdpNet.h"
+#include "ShmNet.h"
+#include "TimerWheel.h"
 #include "MP2Node.h"
 #include "Node.h"
 #include "common.h"
+#include "Workload.h"
+#include "Checkpoint.h"
 
 /**
  * global variables
@@ -31,16 +35,34 @@ static const char alphanum[] =
  * Macros
  */
 #define ARGS_COUNT 2
-#define TOTAL_RUNNING_TIME 700
-#define INSERT_TIME (TOTAL_RUNNING_TIME-600)
+// With BOOTSTRAP the ring is complete after the first tick
+#define INSERT_TIME (par->BOOTSTRAP ? 1 : par->TOTAL_RUNNING_TIME-600)
 #define TEST_TIME (INSERT_TIME+50)
 #define STABILIZE_TIME 50
+// Ticks for the membership to converge once all nodes have joined
+#define CONVERGE_TIME 50
 #define FIRST_FAIL_TIME 25
 #define LAST_FAIL_TIME 10
 #define RF 3
 #define NUMBER_OF_INSERTS 100
 #define KEY_LENGTH 5
 
+enum appEventType {
+	NODE_START,
+	NODE_LOOP
+};
+
+/**
+ * Struct Name: app_event
+ *
+ * DESCRIPTION: Something the application layer has to do for a node at a given
+ * 				tick: introduce it or run its periodic loop
+ */
+typedef struct app_event {
+	int node;
+	int type;
+}app_event;
+
 /**
  * CLASS NAME: Application
  *
@@ -52,12 +74,33 @@ private:
 	// Coordinator Node
 	char JOINADDR[30];
 	EmulNet *en;
-	EmulNet *en1;
     Log *log;
-	MP1Node **mp1;
-	MP2Node **mp2;
+	vector<MP1Node *> mp1;
+	vector<MP2Node *> mp2;
 	Params *par;
+	// Runs the per-node tasks of every phase
+	Executor *exec;
 	map<string, string> testKVPairs;
+	// Operations of CRUD_TEST: WORKLOAD, NULL for the other tests
+	Workload *workload;
+	// Node starts and node loops, keyed on the tick they are due
+	TimerWheel<app_event> events;
+	// Ids of nodes with messages waiting that have not started yet
+	vector<int> held;
+	// Tick of the pending NODE_LOOP of every node, -1 while it only waits for messages
+	vector<int> loopAt;
+	// Nodes whose loop ran in this tick, from the last one down
+	vector<int> looping;
+	// Tick all nodes had joined at, once they have
+	int timeWhenAllNodesHaveJoined;
+	bool allNodesJoined;
+	void runPhase(int tasks, const function<void(int)> &task);
+	void printLatency(FILE *file);
+	bool checkpoint(Checkpoint &cp);
+	bool checkpoint(const char *file, bool save);
+	void schedule(int time, int node, int type);
+	void scheduleLoop(int i);
+	void bootstrap();
 public:
 	Application(char *);
 	virtual ~Application();
@@ -70,6 +113,7 @@ public:
 	void insertTestKVPairs();
 	int findARandomNodeThatIsAlive();
 	void deleteTest();
+	void runWorkload();
 	void readTest();
 	void updateTest();
 };
@@ -0,0 +1,107 @@
+/**********************************
+ * FILE NAME: Checkpoint.cpp
+ *
+ * DESCRIPTION: Definition of the simulation checkpoint file
+ **********************************/
+
+#include "Checkpoint.h"
+
+/**
+ * Constructor
+ */
+Checkpoint::Checkpoint(): fp(NULL), writing(false), failed(false) {}
+
+/**
+ * Destructor
+ */
+Checkpoint::~Checkpoint() {
+	close();
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Open file for writing a checkpoint and write its header
+ *
+ * RETURNS:
+ * false if the file could not be created
+ */
+bool Checkpoint::save(const char *file) {
+	unsigned long long magic = CHECKPOINT_MAGIC;
+	int version = CHECKPOINT_VERSION;
+
+	close();
+	fp = fopen(file, "wb");
+	writing = true;
+	failed = false;
+	if ( fp == NULL ) {
+		return false;
+	}
+	io(magic);
+	io(version);
+	return ok();
+}
+
+/**
+ * FUNCTION NAME: restore
+ *
+ * DESCRIPTION: Open file for reading a checkpoint and check its header
+ *
+ * RETURNS:
+ * false if the file cannot be read or was not written by this version
+ */
+bool Checkpoint::restore(const char *file) {
+	unsigned long long magic = 0;
+	int version = 0;
+
+	close();
+	fp = fopen(file, "rb");
+	writing = false;
+	failed = false;
+	if ( fp == NULL ) {
+		return false;
+	}
+	io(magic);
+	io(version);
+	if ( magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION ) {
+		failed = true;
+	}
+	return ok();
+}
+
+/**
+ * FUNCTION NAME: close
+ *
+ * DESCRIPTION: Flush and close the file
+ *
+ * RETURNS:
+ * false if anything went wrong since save or restore
+ */
+bool Checkpoint::close() {
+	bool good = ok();
+
+	if ( fp != NULL ) {
+		if ( fclose(fp) != 0 ) {
+			good = false;
+		}
+		fp = NULL;
+	}
+	return good;
+}
+
+/**
+ * FUNCTION NAME: bytes
+ *
+ * DESCRIPTION: Write size bytes from data, or read them into data
+ */
+void Checkpoint::bytes(void *data, size_t size) {
+	if ( fp == NULL || failed || size == 0 ) {
+		return;
+	}
+	if ( writing ) {
+		failed = fwrite(data, 1, size, fp) != size;
+	}
+	else {
+		failed = fread(data, 1, size, fp) != size;
+	}
+}
@@ -0,0 +1,122 @@
+/**********************************
+ * FILE NAME: Checkpoint.h
+ *
+ * DESCRIPTION: Header file of the simulation checkpoint file
+ **********************************/
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include "stdincludes.h"
+#include <type_traits>
+
+/*
+ * Macros
+ */
+#define CHECKPOINT_MAGIC 0x4b56435055ULL
+#define CHECKPOINT_VERSION 8
+
+/**
+ * CLASS NAME: Checkpoint
+ *
+ * DESCRIPTION: Binary snapshot of the simulator state, written by one run and
+ * 				read back by a later one. The same io() calls serve both ways:
+ * 				when saving they write the value, when restoring they overwrite
+ * 				it with what was saved, so every class lists its state once in
+ * 				a checkpoint(Checkpoint &) method. Plain values are copied as
+ * 				bytes, strings, vectors, maps and pairs element by element.
+ * 				A short read or write marks the checkpoint as failed, which the
+ * 				caller checks with ok() once it is done.
+ */
+class Checkpoint {
+private:
+	FILE *fp;
+	bool writing;
+	bool failed;
+
+	// Vectors of numbers go in one piece, anything else element by element
+	template <class T>
+	void elements(vector<T> &v, true_type) {
+		if ( !v.empty() ) {
+			bytes(&v[0], v.size() * sizeof(T));
+		}
+	}
+
+	template <class T>
+	void elements(vector<T> &v, false_type) {
+		for ( size_t i = 0; i < v.size(); i++ ) {
+			io(v[i]);
+		}
+	}
+
+public:
+	Checkpoint();
+	Checkpoint(const Checkpoint &anotherCheckpoint) = delete;
+	Checkpoint& operator =(const Checkpoint &anotherCheckpoint) = delete;
+	virtual ~Checkpoint();
+	bool save(const char *file);
+	bool restore(const char *file);
+	bool close();
+	bool saving() {
+		return writing;
+	}
+	bool ok() {
+		return fp && !failed;
+	}
+	void bytes(void *data, size_t size);
+
+	template <class T>
+	void io(T &value) {
+		bytes(&value, sizeof(T));
+	}
+
+	void io(string &s) {
+		size_t size = s.size();
+		io(size);
+		if ( !writing ) {
+			s.resize(failed ? 0 : size);
+		}
+		if ( !s.empty() ) {
+			bytes(&s[0], s.size());
+		}
+	}
+
+	template <class A, class B>
+	void io(pair<A, B> &p) {
+		io(p.first);
+		io(p.second);
+	}
+
+	template <class T>
+	void io(vector<T> &v) {
+		size_t size = v.size();
+		io(size);
+		if ( !writing ) {
+			v.clear();
+			v.resize(failed ? 0 : size);
+		}
+		elements(v, typename is_arithmetic<T>::type());
+	}
+
+	template <class K, class V>
+	void io(map<K, V> &m) {
+		size_t size = m.size();
+		io(size);
+		if ( writing ) {
+			for ( typename map<K, V>::iterator it = m.begin(); it != m.end(); ++it ) {
+				K key = it->first;
+				io(key);
+				io(it->second);
+			}
+			return;
+		}
+		m.clear();
+		for ( size_t i = 0; i < size && !failed; i++ ) {
+			K key;
+			io(key);
+			io(m[key]);
+		}
+	}
+};
+
+#endif /* _CHECKPOINT_H_ */
@@ -6,114 +6,356 @@
 
 #include "EmulNet.h"
 
+// Names of the channels in msgcount.log and netstats.log
+static const char *enChannelNames[EN_CHANNELS] = {"membership", "kv"};
+
 /**
  * Constructor
  */
 EmulNet::EmulNet(Params *p)
 {
 	//trace.funcEntry("EmulNet::EmulNet");
-	int i,j;
 	par = p;
 	emulnet.setNextId(1);
 	emulnet.settCurrBuffSize(0);
+	emulnet.peakbuffsize = 0;
 	enInited=0;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			sent_msgs[i][j] = 0;
-			recv_msgs[i][j] = 0;
-		}
-	}
+	overflowDrops = 0;
+	randomDrops = 0;
+	oversizeDrops = 0;
+	sentBytes.assign(EN_CHANNELS, 0);
+	delayedMsgs = 0;
+	totalDelay = 0;
+	maxDelay = 0;
+	staging = false;
+	soloId = -1;
+	// One (initially empty) row per channel and node; rows only grow as ticks with traffic go by
+	sent_msgs.assign(EN_CHANNELS, vector< vector<int> >(par->EN_GPSZ + 1));
+	recv_msgs.assign(EN_CHANNELS, vector< vector<int> >(par->EN_GPSZ + 1));
 	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
 
 /**
- * Copy constructor
+ * Destructor
  */
-EmulNet::EmulNet(EmulNet &anotherEmulNet) {
-	int i, j;
-	this->par = anotherEmulNet.par;
-	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
+EmulNet::~EmulNet() {}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Init the emulnet for this node
+ */
+void *EmulNet::ENinit(Address *myaddr, short port) {
+	// Initialize data structures for this member
+	*(int *)(myaddr->addr) = emulnet.nextid++;
+    *(short *)(&myaddr->addr[4]) = 0;
+	emulnet.mailbox.resize(emulnet.nextid);
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: getMailbox
+ *
+ * DESCRIPTION: Return the mailbox of the node with the given address.
+ * 				The mailbox table grows on demand so that an EmulNet whose
+ * 				nodes were ENinit'ed elsewhere can still deliver to them.
+ *
+ * RETURNS:
+ * NULL if the address does not carry a valid node id
+ */
+vector<en_msg *> *EmulNet::getMailbox(Address *addr) {
+	int id = *(int *)(addr->addr);
+
+	if ( id < 0 ) {
+		return NULL;
+	}
+	if ( id >= (int)emulnet.mailbox.size() ) {
+		emulnet.mailbox.resize(id + 1);
+	}
+	return &emulnet.mailbox[id];
+}
+
+/**
+ * FUNCTION NAME: countMsg
+ *
+ * DESCRIPTION: Count n messages for node at time.
+ * 				Grows the table by node and by COUNTER_BUCKET ticks as needed.
+ * 				Without DETAILED_LOGS every tick goes to slot 0, which keeps the
+ * 				table at one counter per node for long runs.
+ */
+void EmulNet::countMsg(vector< vector<int> > &counts, int node, int time, int n) {
+	if ( !par->DETAILED_LOGS ) {
+		time = 0;
+	}
+	if ( node >= (int)counts.size() ) {
+		counts.resize(node + 1);
+	}
+
+	vector<int> &row = counts[node];
+
+	if ( time >= (int)row.size() ) {
+		row.resize((time / COUNTER_BUCKET + 1) * COUNTER_BUCKET, 0);
+	}
+	row[time] += n;
+}
+
+/**
+ * FUNCTION NAME: getCount
+ *
+ * DESCRIPTION: Number of messages counted for node at time
+ */
+int EmulNet::getCount(vector< vector<int> > &counts, int node, int time) {
+	if ( node >= (int)counts.size() || time >= (int)counts[node].size() ) {
+		return 0;
+	}
+	return counts[node][time];
+}
+
+/**
+ * FUNCTION NAME: linkDelay
+ *
+ * DESCRIPTION: Time in ticks a message of size bytes from node src spends on the wire:
+ * 				the wait for and transmission over the sender's egress link when
+ * 				EGRESS_BANDWIDTH is set, plus a latency drawn from LATENCY_MODEL
+ */
+double EmulNet::linkDelay(int src, int size) {
+	double now = par->getcurrtime();
+	double delay = 0;
+	double u;
+
+	if ( par->EGRESS_BANDWIDTH > 0 ) {
+		if ( src >= (int)linkFree.size() ) {
+			linkFree.resize(src + 1, 0);
 		}
+		linkFree[src] = max(now, linkFree[src]) + (double)size / par->EGRESS_BANDWIDTH;
+		delay = linkFree[src] - now;
 	}
-	this->emulnet = anotherEmulNet.emulnet;
+
+	switch ( par->LATENCY_MODEL ) {
+		case FIXED_LATENCY:
+			delay += par->LATENCY_MIN;
+			break;
+		case UNIFORM_LATENCY:
+			delay += par->LATENCY_MIN + (par->LATENCY_MAX - par->LATENCY_MIN) * (rand() / (RAND_MAX + 1.0));
+			break;
+		case LONGTAIL_LATENCY:
+			// Pareto with scale LATENCY_MIN and shape LATENCY_ALPHA, optionally capped
+			u = 1.0 - rand() / (RAND_MAX + 1.0);
+			u = par->LATENCY_MIN / pow(u, 1.0 / par->LATENCY_ALPHA);
+			if ( par->LATENCY_MAX > 0 && u > par->LATENCY_MAX ) {
+				u = par->LATENCY_MAX;
+			}
+			delay += u;
+			break;
+		default:
+			break;
+	}
+
+	return delay;
 }
 
 /**
- * Assignment operator overloading
+ * FUNCTION NAME: deliverDue
+ *
+ * DESCRIPTION: Move every message whose delay has run out from the wire into its mailbox
  */
-EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet) {
-	int i, j;
-	this->par = anotherEmulNet.par;
-	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
+void EmulNet::deliverDue() {
+	vector<en_msg *> due;
+
+	if ( wire.size() == 0 ) {
+		return;
+	}
+	wire.advance(par->getcurrtime(), due);
+	for ( unsigned int i = 0; i < due.size(); i++ ) {
+		getMailbox(&due[i]->to)->push_back(due[i]);
+		markReady(*(int *)(due[i]->to.addr));
+	}
+}
+
+/**
+ * FUNCTION NAME: park
+ *
+ * DESCRIPTION: Hold a message in flight: on the wire until tick due, or in the
+ * 				destination mailbox if it is already due
+ */
+void EmulNet::park(en_msg *em, int due) {
+	if ( due > par->getcurrtime() ) {
+		wire.schedule(due, em);
+	}
+	else {
+		getMailbox(&em->to)->push_back(em);
+		markReady(*(int *)(em->to.addr));
+	}
+	emulnet.currbuffsize++;
+	if ( emulnet.currbuffsize > emulnet.peakbuffsize ) {
+		emulnet.peakbuffsize = emulnet.currbuffsize;
+	}
+}
+
+/**
+ * FUNCTION NAME: markReady
+ *
+ * DESCRIPTION: Note that node id has messages to pick up, see ENready
+ */
+void EmulNet::markReady(int id) {
+	if ( id < 0 ) {
+		return;
+	}
+	if ( id >= (int)readyFlag.size() ) {
+		readyFlag.resize(id + 1, 0);
+	}
+	if ( !readyFlag[id] ) {
+		readyFlag[id] = 1;
+		readyIds.push_back(id);
+	}
+}
+
+/**
+ * FUNCTION NAME: transmit
+ *
+ * DESCRIPTION: Emulated transmission: the message is parked in flight for the
+ * 				delay given by the latency and bandwidth model
+ */
+void EmulNet::transmit(en_msg *em) {
+	int time = par->getcurrtime();
+	double delay = linkDelay(*(int *)(em->from.addr), em->size);
+
+	if ( delay > 0 ) {
+		// A message sent at tick t is visible from tick t + delay on; anything
+		// up to one tick is hidden by the tick granularity
+		delayedMsgs++;
+		totalDelay += delay;
+		if ( delay > maxDelay ) {
+			maxDelay = delay;
 		}
+		park(em, time + (int)ceil(delay));
+	}
+	else {
+		park(em, time);
 	}
-	this->emulnet = anotherEmulNet.emulnet;
-	return *this;
 }
 
 /**
- * Destructor
+ * FUNCTION NAME: collect
+ *
+ * DESCRIPTION: Emulated reception: release the messages whose delay has run out
  */
-EmulNet::~EmulNet() {}
+void EmulNet::collect(Address *addr) {
+	deliverDue();
+}
 
 /**
- * FUNCTION NAME: ENinit
+ * FUNCTION NAME: ENalloc
  *
- * DESCRIPTION: Init the emulnet for this node
+ * DESCRIPTION: Allocate a message buffer of size bytes from the message pool for
+ * 				a message on the given channel. The caller serializes its message
+ * 				into the buffer and passes it to ENsendBuffer, which takes ownership.
  */
-void *EmulNet::ENinit(Address *myaddr, short port) {
-	// Initialize data structures for this member
-	*(int *)(myaddr->addr) = emulnet.nextid++;
-    *(short *)(&myaddr->addr[4]) = 0;
-	return myaddr;
+char *EmulNet::ENalloc(int size, int channel) {
+	lock_guard<recursive_mutex> guard(netLock);
+	en_buf *buf = (en_buf *)pool.allocate(sizeof(en_buf) + size);
+
+	buf->refs = 1;
+	buf->size = size;
+	buf->channel = channel;
+	return (char *)(buf + 1);
+}
+
+/**
+ * FUNCTION NAME: ENmaxSize
+ *
+ * DESCRIPTION: Largest message ENsend delivers; anything bigger is dropped as oversize
+ */
+int EmulNet::ENmaxSize() {
+	return par->MAX_MSG_SIZE - (int)sizeof(en_msg) - 1;
 }
 
 /**
  * FUNCTION NAME: ENsend
  *
- * DESCRIPTION: EmulNet send function
+ * DESCRIPTION: EmulNet send function. Copies data into a pooled message buffer.
  *
  * RETURNS:
  * size
  */
-int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
+int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size, int channel) {
+	char *buff = ENalloc(size, channel);
+
+	memcpy(buff, data, size);
+	return ENsendBuffer(myaddr, toaddr, buff);
+}
+
+/**
+ * FUNCTION NAME: ENsendBuffer
+ *
+ * DESCRIPTION: EmulNet send function for a buffer obtained from ENalloc.
+ * 				The buffer itself travels to the receiver; it is released here
+ * 				if the message is dropped.
+ *
+ * RETURNS:
+ * size
+ */
+int EmulNet::ENsendBuffer(Address *myaddr, Address *toaddr, char *buff) {
 	en_msg *em;
 	static char temp[2048];
+	int size = ((en_buf *)buff - 1)->size;
+	int task = Executor::currentTask();
+
+	if ( staging && task >= 0 ) {
+		// Sent from a node task: queue it in the task's outbox, ENflush sends it
+		en_staged staged;
+		staged.from = *myaddr;
+		staged.to = *toaddr;
+		staged.data = buff;
+		outbox[task].push_back(staged);
+		return size;
+	}
+
 	int sendmsg = rand() % 100;
+	vector<en_msg *> *mailbox = getMailbox(toaddr);
 
-	if( (emulnet.currbuffsize >= ENBUFFSIZE) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+	if( mailbox == NULL ) {
+		ENfree(buff);
+		return 0;
+	}
+	// Congestion loss, only when a capacity is configured
+	if( (par->EN_BUFFSIZE > 0 && emulnet.currbuffsize >= par->EN_BUFFSIZE) || (par->EN_NODEBUFFSIZE > 0 && (int)mailbox->size() >= par->EN_NODEBUFFSIZE) ) {
+		overflowDrops++;
+		ENfree(buff);
+		return 0;
+	}
+	if( size > ENmaxSize() ) {
+		oversizeDrops++;
+		ENfree(buff);
+		return 0;
+	}
+	// Injected loss
+	if( par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100) ) {
+		randomDrops++;
+		ENfree(buff);
 		return 0;
 	}
 
-	em = (en_msg *)malloc(sizeof(en_msg) + size);
+	em = (en_msg *)pool.allocate(sizeof(en_msg));
 	em->size = size;
+	em->channel = ((en_buf *)buff - 1)->channel;
 
 	memcpy(&(em->from.addr), &(myaddr->addr), sizeof(em->from.addr));
 	memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->from.addr));
-	memcpy(em + 1, data, size);
-
-	emulnet.buff[emulnet.currbuffsize++] = em;
+	em->data = buff;
 
 	int src = *(int *)(myaddr->addr);
 	int time = par->getcurrtime();
 
-	assert(src <= MAX_NODES);
-	assert(time < MAX_TIME);
-
-	sent_msgs[src][time]++;
+	countMsg(sent_msgs[em->channel], src, time);
+	sentBytes[em->channel] += size;
 
 	#ifdef DEBUGLOG
-		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)data, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
+		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)buff, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
 	#endif
 
+	transmit(em);
+
 	return size;
 }
 
@@ -125,96 +367,473 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
  * RETURNS:
  * size
  */
-int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data) {
-	char * str = (char *) malloc(data.length() * sizeof(char));
-	memcpy(str, data.c_str(), data.size());
-	int ret = this->ENsend(myaddr, toaddr, str, (data.length() * sizeof(char)));
-	free(str);
-	return ret;
+int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data, int channel) {
+	char *buff = ENalloc(data.size() * sizeof(char), channel);
+	memcpy(buff, data.data(), data.size());
+	return ENsendBuffer(myaddr, toaddr, buff);
+}
+
+/**
+ * FUNCTION NAME: ENsendMulti
+ *
+ * DESCRIPTION: EmulNet send function for the same message to several nodes.
+ * 				The buffer obtained from ENalloc is shared by all the envelopes:
+ * 				each destination holds one reference and gives it back when its
+ * 				copy is dropped or consumed. Drops are decided per destination.
+ *
+ * RETURNS:
+ * number of destinations the message was sent to
+ */
+int EmulNet::ENsendMulti(Address *myaddr, vector<Address> &toaddrs, char *buff) {
+	int sent = 0;
+
+	if ( toaddrs.empty() ) {
+		ENfree(buff);
+		return 0;
+	}
+
+	((en_buf *)buff - 1)->refs = toaddrs.size();
+	for ( unsigned int i = 0; i < toaddrs.size(); i++ ) {
+		if ( ENsendBuffer(myaddr, &toaddrs[i], buff) > 0 ) {
+			sent++;
+		}
+	}
+	return sent;
+}
+
+/**
+ * FUNCTION NAME: ENsendMulti
+ *
+ * DESCRIPTION: EmulNet send function for the same message to several nodes,
+ * 				copies data once into a shared message buffer
+ *
+ * RETURNS:
+ * number of destinations the message was sent to
+ */
+int EmulNet::ENsendMulti(Address *myaddr, vector<Address> &toaddrs, string data, int channel) {
+	char *buff = ENalloc(data.size() * sizeof(char), channel);
+	memcpy(buff, data.data(), data.size());
+	return ENsendMulti(myaddr, toaddrs, buff);
 }
 
 /**
- * FUNCTION NAME: ENrecv
+ * FUNCTION NAME: ENrecvBatch
  *
- * DESCRIPTION: EmulNet receive function
+ * DESCRIPTION: EmulNet receive function. Moves every message waiting for this
+ * 				node to the end of batch in one call, in the order they were sent,
+ * 				whatever their channel.
  *
  * RETURN:
- * 0
+ * number of messages received
  */
-int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue){
-	// times is always assumed to be 1
-	int i;
-	char* tmp;
-	int sz;
+int EmulNet::ENrecvBatch(Address *myaddr, vector<q_elt> &batch) {
+	vector<q_elt> *queues[EN_CHANNELS];
+
+	for ( int c = 0; c < EN_CHANNELS; c++ ) {
+		queues[c] = &batch;
+	}
+	return ENrecvBatch(myaddr, queues);
+}
+
+/**
+ * FUNCTION NAME: ENrecvBatch
+ *
+ * DESCRIPTION: EmulNet receive function. Moves every message waiting for this
+ * 				node to the end of the queue of its channel, in one pass over the
+ * 				mailbox; each queue keeps the order its messages were sent in.
+ *
+ * RETURN:
+ * number of messages received
+ */
+int EmulNet::ENrecvBatch(Address *myaddr, vector<q_elt> *queues[EN_CHANNELS]) {
+	lock_guard<recursive_mutex> guard(netLock);
+	unsigned int i;
+	int c;
 	en_msg *emsg;
+	vector<en_msg *> *mailbox;
+	int counts[EN_CHANNELS] = {0};
 
-	for( i = emulnet.currbuffsize - 1; i >= 0; i-- ) {
-		emsg = emulnet.buff[i];
+	collect(myaddr);
+	mailbox = getMailbox(myaddr);
+
+	int dst = *(int *)(myaddr->addr);
+	if ( dst >= 0 && dst < (int)readyFlag.size() ) {
+		readyFlag[dst] = 0;
+	}
+
+	if ( mailbox == NULL || mailbox->empty() ) {
+		return 0;
+	}
 
-		if ( 0 == strcmp(emsg->to.addr, myaddr->addr) ) {
-			sz = emsg->size;
-			tmp = (char *) malloc(sz * sizeof(char));
-			memcpy(tmp, (char *)(emsg+1), sz);
+	int time = par->getcurrtime();
+	int count = mailbox->size();
 
-			emulnet.buff[i] = emulnet.buff[emulnet.currbuffsize-1];
-			emulnet.currbuffsize--;
+	for( i = 0; i < mailbox->size(); i++ ) {
+		emsg = (*mailbox)[i];
+		c = emsg->channel;
 
-			(*enq)(queue, (char *)tmp, sz);
+		// The sender's buffer moves into the queue; the receiver frees it with ENfree
+		queues[c]->push_back(q_elt(emsg->data, emsg->size));
+		counts[c]++;
 
-			free(emsg);
+		pool.release(emsg);
+	}
+	for ( c = 0; c < EN_CHANNELS; c++ ) {
+		if ( counts[c] > 0 ) {
+			countMsg(recv_msgs[c], dst, time, counts[c]);
+		}
+	}
 
-			int dst = *(int *)(myaddr->addr);
-			int time = par->getcurrtime();
+	emulnet.currbuffsize -= count;
+	mailbox->clear();
 
-			assert(dst <= MAX_NODES);
-			assert(time < MAX_TIME);
+	return count;
+}
 
-			recv_msgs[dst][time]++;
+/**
+ * FUNCTION NAME: ENready
+ *
+ * DESCRIPTION: Append the ids of the nodes that have messages to pick up and
+ * 				have not called ENrecvBatch since, in the order they got them.
+ * 				Nodes that are not listed would receive nothing this tick.
+ */
+void EmulNet::ENready(vector<int> &ids) {
+	lock_guard<recursive_mutex> guard(netLock);
+
+	deliverDue();
+	for ( unsigned int i = 0; i < readyIds.size(); i++ ) {
+		if ( readyFlag[readyIds[i]] ) {
+			readyFlag[readyIds[i]] = 0;
+			ids.push_back(readyIds[i]);
 		}
 	}
+	readyIds.clear();
+}
 
-	return 0;
+/**
+ * FUNCTION NAME: ENsolo
+ *
+ * DESCRIPTION: Serve a process that runs node id and no other: the next ENinit
+ * 				hands out id, and every other node lives in a process of its own,
+ * 				so it is only ever sent to
+ */
+void EmulNet::ENsolo(int id) {
+	soloId = id;
+	emulnet.setNextId(id);
 }
 
 /**
- * FUNCTION NAME: ENcleanup
+ * FUNCTION NAME: ENwait
  *
- * DESCRIPTION: Cleanup the EmulNet. Called exactly once at the end of the program.
+ * DESCRIPTION: Block until deadline, in ENclock time, then collect what reached
+ * 				this node. The emulated network only moves messages between
+ * 				nodes of one process, so there is nothing to wait for.
  */
-int EmulNet::ENcleanup() {
-	emulnet.nextid=0;
+void EmulNet::ENwait(Address *myaddr, long long deadline) {
+	struct timespec ts;
+
+	ts.tv_sec = deadline / 1000000;
+	ts.tv_nsec = deadline % 1000000 * 1000;
+	while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR );
+
+	lock_guard<recursive_mutex> guard(netLock);
+	collect(myaddr);
+}
+
+/**
+ * FUNCTION NAME: ENclock
+ *
+ * DESCRIPTION: Microseconds on the monotonic clock, the time base of ENwait
+ */
+long long EmulNet::ENclock() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * FUNCTION NAME: ENnextDelivery
+ *
+ * DESCRIPTION: Earliest tick at which a node has messages to pick up
+ *
+ * RETURNS:
+ * -1 if no message is in flight
+ */
+int EmulNet::ENnextDelivery() {
+	lock_guard<recursive_mutex> guard(netLock);
+
+	for ( unsigned int i = 0; i < readyIds.size(); i++ ) {
+		if ( readyFlag[readyIds[i]] ) {
+			return par->getcurrtime();
+		}
+	}
+	return wire.nextDue();
+}
+
+/**
+ * FUNCTION NAME: ENfree
+ *
+ * DESCRIPTION: Drop a reference to a message buffer handed out by ENrecvBatch or ENalloc.
+ * 				Receivers call this once they are done with a message; the buffer
+ * 				goes back to the message pool with its last reference.
+ */
+void EmulNet::ENfree(void *data) {
+	lock_guard<recursive_mutex> guard(netLock);
+	en_buf *buf = (en_buf *)data - 1;
+
+	if ( --buf->refs == 0 ) {
+		pool.release(buf);
+	}
+}
+
+/**
+ * FUNCTION NAME: ENstage
+ *
+ * DESCRIPTION: Hold back the sends node tasks make until ENflush. While the
+ * 				tasks of a phase run in parallel, each one only fills its own
+ * 				outbox; ENflush then sends everything in task order, so drops,
+ * 				delays, mailbox order and counters come out exactly as if the
+ * 				tasks had run one after another.
+ */
+void EmulNet::ENstage(int tasks) {
+	if ( (int)outbox.size() < tasks ) {
+		outbox.resize(tasks);
+	}
+	staging = true;
+}
+
+/**
+ * FUNCTION NAME: ENflush
+ *
+ * DESCRIPTION: Send what the tasks staged, in task order, and stop staging
+ */
+void EmulNet::ENflush() {
+	staging = false;
+	for ( unsigned int i = 0; i < outbox.size(); i++ ) {
+		for ( unsigned int j = 0; j < outbox[i].size(); j++ ) {
+			en_staged &staged = outbox[i][j];
+			ENsendBuffer(&staged.from, &staged.to, staged.data);
+		}
+		outbox[i].clear();
+	}
+}
+
+/**
+ * FUNCTION NAME: checkpointMsg
+ *
+ * DESCRIPTION: Save a message in flight, or restore one into a new envelope and buffer
+ */
+void EmulNet::checkpointMsg(Checkpoint &cp, en_msg *&em) {
+	int size = cp.saving() ? em->size : 0;
+	int channel = cp.saving() ? em->channel : 0;
+
+	cp.io(size);
+	cp.io(channel);
+	if ( !cp.saving() ) {
+		em = (en_msg *)pool.allocate(sizeof(en_msg));
+		em->size = cp.ok() ? size : 0;
+		em->channel = cp.ok() && channel >= 0 && channel < EN_CHANNELS ? channel : MEMBERSHIP_CHANNEL;
+		em->data = ENalloc(em->size, em->channel);
+	}
+	cp.io(em->from);
+	cp.io(em->to);
+	cp.bytes(em->data, em->size);
+}
+
+/**
+ * FUNCTION NAME: ENcheckpoint
+ *
+ * DESCRIPTION: Save the state of the network, with every message in a mailbox or
+ * 				on the wire, or restore it into a network whose nodes were just
+ * 				ENinit'ed. Only the emulated network can be restored: the other
+ * 				transports keep their messages in flight outside the process.
+ */
+void EmulNet::ENcheckpoint(Checkpoint &cp) {
+	lock_guard<recursive_mutex> guard(netLock);
+	vector< pair<int, en_msg *> > flying;
+	int boxes = emulnet.mailbox.size();
+	int count;
 	int i, j;
-	int sent_total, recv_total;
 
-	FILE* file = fopen("msgcount.log", "w+");
+	cp.io(emulnet.nextid);
+	cp.io(emulnet.currbuffsize);
+	cp.io(emulnet.peakbuffsize);
+	cp.io(emulnet.firsteltindex);
+	cp.io(enInited);
+	cp.io(sent_msgs);
+	cp.io(recv_msgs);
+	cp.io(overflowDrops);
+	cp.io(randomDrops);
+	cp.io(oversizeDrops);
+	cp.io(sentBytes);
+	cp.io(linkFree);
+	cp.io(delayedMsgs);
+	cp.io(totalDelay);
+	cp.io(maxDelay);
+	cp.io(readyIds);
+	cp.io(readyFlag);
+
+	cp.io(boxes);
+	if ( !cp.saving() ) {
+		emulnet.mailbox.resize(cp.ok() ? boxes : 0);
+	}
+	for ( i = 0; i < (int)emulnet.mailbox.size() && cp.ok(); i++ ) {
+		count = emulnet.mailbox[i].size();
+		cp.io(count);
+		if ( !cp.saving() ) {
+			emulnet.mailbox[i].resize(cp.ok() ? count : 0, NULL);
+		}
+		for ( j = 0; j < (int)emulnet.mailbox[i].size(); j++ ) {
+			checkpointMsg(cp, emulnet.mailbox[i][j]);
+		}
+	}
 
-	while(emulnet.currbuffsize > 0) {
-		free(emulnet.buff[--emulnet.currbuffsize]);
+	// Messages on the wire go with the tick they are due at
+	if ( cp.saving() ) {
+		wire.list(flying);
+	}
+	count = flying.size();
+	cp.io(count);
+	if ( !cp.saving() ) {
+		flying.resize(cp.ok() ? count : 0);
+	}
+	for ( j = 0; j < (int)flying.size(); j++ ) {
+		cp.io(flying[j].first);
+		checkpointMsg(cp, flying[j].second);
+		if ( !cp.saving() ) {
+			wire.schedule(flying[j].first, flying[j].second);
+		}
 	}
+}
+
+/**
+ * FUNCTION NAME: ENcheckpoint
+ *
+ * DESCRIPTION: Save the messages a node received and has not handled yet, or
+ * 				restore them into buffers of this network
+ */
+void EmulNet::ENcheckpoint(Checkpoint &cp, vector<q_elt> &queue) {
+	int count = queue.size();
+	int size;
+	char *data;
+
+	cp.io(count);
+	for ( int i = 0; i < count && cp.ok(); i++ ) {
+		if ( cp.saving() ) {
+			size = queue[i].size;
+			cp.io(size);
+			cp.bytes(queue[i].elt, size);
+		}
+		else {
+			cp.io(size);
+			if ( !cp.ok() ) {
+				break;
+			}
+			data = ENalloc(size);
+			cp.bytes(data, size);
+			queue.push_back(q_elt(data, size));
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: printCounts
+ *
+ * DESCRIPTION: Print the messages every node sent and received on channel, per tick
+ * 				with DETAILED_LOGS, and in total
+ */
+void EmulNet::printCounts(FILE *file, int channel) {
+	int i, j;
+	int sent, recv;
+	int sent_total, recv_total;
 
 	for ( i = 1; i <= par->EN_GPSZ; i++ ) {
+		if ( soloId >= 0 && i != soloId ) {
+			// counted by the process of that node
+			continue;
+		}
 		fprintf(file, "node %3d ", i);
 		sent_total = 0;
 		recv_total = 0;
 
-		for (j = 0; j < par->getcurrtime(); j++) {
+		if ( !par->DETAILED_LOGS ) {
+			sent_total = getCount(sent_msgs[channel], i, 0);
+			recv_total = getCount(recv_msgs[channel], i, 0);
+		}
+
+		for (j = 0; par->DETAILED_LOGS && j < par->getcurrtime(); j++) {
 
-			sent_total += sent_msgs[i][j];
-			recv_total += recv_msgs[i][j];
+			sent = getCount(sent_msgs[channel], i, j);
+			recv = getCount(recv_msgs[channel], i, j);
+			sent_total += sent;
+			recv_total += recv;
 			if (i != 67) {
-				fprintf(file, " (%4d, %4d)", sent_msgs[i][j], recv_msgs[i][j]);
+				fprintf(file, " (%4d, %4d)", sent, recv);
 				if (j % 10 == 9) {
 					fprintf(file, "\n         ");
 				}
 			}
 			else {
-				fprintf(file, "special %4d %4d %4d\n", j, sent_msgs[i][j], recv_msgs[i][j]);
+				fprintf(file, "special %4d %4d %4d\n", j, sent, recv);
 			}
 		}
 		fprintf(file, "\n");
 		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n\n", i, sent_total, recv_total);
 	}
+}
 
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Cleanup the EmulNet. Called exactly once at the end of the program.
+ * 				msgcount.log gets the membership channel first, then every other
+ * 				channel that carried messages under a header of its own.
+ */
+int EmulNet::ENcleanup() {
+	emulnet.nextid=0;
+	int i, j, c;
+	bool used;
+
+	FILE* file = fopen("msgcount.log", "w+");
+
+	for ( i = 0; i < (int)emulnet.mailbox.size(); i++ ) {
+		for ( j = 0; j < (int)emulnet.mailbox[i].size(); j++ ) {
+			ENfree(emulnet.mailbox[i][j]->data);
+			pool.release(emulnet.mailbox[i][j]);
+		}
+		emulnet.mailbox[i].clear();
+	}
+	vector<en_msg *> onWire;
+	wire.drain(onWire);
+	for ( i = 0; i < (int)onWire.size(); i++ ) {
+		ENfree(onWire[i]->data);
+		pool.release(onWire[i]);
+	}
+	emulnet.currbuffsize = 0;
+
+	printCounts(file, MEMBERSHIP_CHANNEL);
+	for ( c = MEMBERSHIP_CHANNEL + 1; c < EN_CHANNELS; c++ ) {
+		used = false;
+		for ( i = 0; i < (int)sent_msgs[c].size() && !used; i++ ) {
+			used = !sent_msgs[c][i].empty();
+		}
+		if ( used ) {
+			fprintf(file, "channel %s\n\n", enChannelNames[c]);
+			printCounts(file, c);
+		}
+	}
+
+	fclose(file);
+
+	file = fopen(NETSTATS_LOG, "w+");
+	fprintf(file, "inflight peak %d\n", emulnet.peakbuffsize);
+	fprintf(file, "drops overflow %lu random %lu oversize %lu\n", overflowDrops, randomDrops, oversizeDrops);
+	fprintf(file, "delayed %lu mean_delay %.3f max_delay %.3f\n", delayedMsgs, delayedMsgs ? totalDelay / delayedMsgs : 0.0, maxDelay);
+	for ( c = 0; c < EN_CHANNELS; c++ ) {
+		fprintf(file, "bytes %s %lu per_tick %.1f\n", enChannelNames[c], sentBytes[c], par->getcurrtime() > 0 ? (double)sentBytes[c] / par->getcurrtime() : 0.0);
+	}
+	pool.printStats(file);
 	fclose(file);
 	return 0;
 }
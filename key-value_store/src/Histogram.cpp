@@ -0,0 +1,172 @@
+/**********************************
+ * FILE NAME: Histogram.cpp
+ *
+ * DESCRIPTION: Definition of the HDR-style latency histogram
+ **********************************/
+
+#include "Histogram.h"
+
+/**
+ * Constructor
+ */
+Histogram::Histogram(): total(0), sum(0), min(0), max(0) {}
+
+/**
+ * Destructor
+ */
+Histogram::~Histogram() {}
+
+/**
+ * FUNCTION NAME: bucket
+ *
+ * DESCRIPTION: Bucket of a value: the value itself below HIST_SUB_COUNT, then
+ * 				HIST_HALF_COUNT buckets per power of two
+ */
+int Histogram::bucket(unsigned long value) {
+	if ( value < HIST_SUB_COUNT ) {
+		return value;
+	}
+
+	int top = 63 - __builtin_clzl(value);
+	int shift = top - (HIST_SUB_BITS - 1);
+
+	// value >> shift lies in [HIST_HALF_COUNT, HIST_SUB_COUNT)
+	return (shift + 1) * HIST_HALF_COUNT + (value >> shift) - HIST_HALF_COUNT;
+}
+
+/**
+ * FUNCTION NAME: highest
+ *
+ * DESCRIPTION: Largest value that falls into the given bucket
+ */
+unsigned long Histogram::highest(int bucket) {
+	if ( bucket < HIST_SUB_COUNT ) {
+		return bucket;
+	}
+
+	int shift = bucket / HIST_HALF_COUNT - 1;
+	unsigned long sub = bucket % HIST_HALF_COUNT + HIST_HALF_COUNT;
+
+	return (sub << shift) + (1UL << shift) - 1;
+}
+
+/**
+ * FUNCTION NAME: record
+ *
+ * DESCRIPTION: Count one occurrence of value
+ */
+void Histogram::record(unsigned long value) {
+	int b = bucket(value);
+
+	if ( b >= (int)counts.size() ) {
+		counts.resize(b + 1, 0);
+	}
+	counts[b]++;
+	if ( total == 0 || value < min ) {
+		min = value;
+	}
+	if ( value > max ) {
+		max = value;
+	}
+	total++;
+	sum += value;
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Add the counts of another histogram to this one
+ */
+void Histogram::add(const Histogram &anotherHistogram) {
+	if ( anotherHistogram.total == 0 ) {
+		return;
+	}
+	if ( anotherHistogram.counts.size() > counts.size() ) {
+		counts.resize(anotherHistogram.counts.size(), 0);
+	}
+	for ( unsigned int i = 0; i < anotherHistogram.counts.size(); i++ ) {
+		counts[i] += anotherHistogram.counts[i];
+	}
+	if ( total == 0 || anotherHistogram.min < min ) {
+		min = anotherHistogram.min;
+	}
+	if ( anotherHistogram.max > max ) {
+		max = anotherHistogram.max;
+	}
+	total += anotherHistogram.total;
+	sum += anotherHistogram.sum;
+}
+
+/**
+ * FUNCTION NAME: valueAt
+ *
+ * DESCRIPTION: Value that percentile percent of the recorded values are at or below,
+ * 				reported as the top of its bucket
+ */
+unsigned long Histogram::valueAt(double percentile) {
+	unsigned long rank = (unsigned long)ceil(percentile / 100 * total);
+	unsigned long seen = 0;
+
+	if ( total == 0 ) {
+		return 0;
+	}
+	if ( rank == 0 ) {
+		rank = 1;
+	}
+	for ( unsigned int i = 0; i < counts.size(); i++ ) {
+		seen += counts[i];
+		if ( seen >= rank ) {
+			return highest(i) < max ? highest(i) : max;
+		}
+	}
+	return max;
+}
+
+/**
+ * FUNCTION NAME: getCount
+ *
+ * DESCRIPTION: getter
+ */
+unsigned long Histogram::getCount() {
+	return total;
+}
+
+/**
+ * FUNCTION NAME: getMin
+ *
+ * DESCRIPTION: getter
+ */
+unsigned long Histogram::getMin() {
+	return min;
+}
+
+/**
+ * FUNCTION NAME: getMax
+ *
+ * DESCRIPTION: getter
+ */
+unsigned long Histogram::getMax() {
+	return max;
+}
+
+/**
+ * FUNCTION NAME: getMean
+ *
+ * DESCRIPTION: Mean of the recorded values
+ */
+double Histogram::getMean() {
+	return total ? (double)sum / total : 0.0;
+}
+
+/**
+ * FUNCTION NAME: checkpoint
+ *
+ * DESCRIPTION: Save or restore the recorded values
+ */
+void Histogram::checkpoint(Checkpoint &cp) {
+	cp.io(counts);
+	cp.io(total);
+	cp.io(sum);
+	cp.io(min);
+	cp.io(max);
+}
@@ -0,0 +1,52 @@
+/**********************************
+ * FILE NAME: Histogram.h
+ *
+ * DESCRIPTION: Header file of the HDR-style latency histogram
+ **********************************/
+
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+#include "stdincludes.h"
+#include "Checkpoint.h"
+
+/*
+ * Macros
+ */
+// Values below 1 << HIST_SUB_BITS get a bucket each; above, every power of two
+// is split into 1 << (HIST_SUB_BITS - 1) buckets, so a value is off by 1/64 at most
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_HALF_COUNT (1 << (HIST_SUB_BITS - 1))
+
+/**
+ * CLASS NAME: Histogram
+ *
+ * DESCRIPTION: Log-linear histogram of non-negative integer values, in the
+ * 				manner of HdrHistogram: exact below HIST_SUB_COUNT, bounded
+ * 				relative error above, with a fixed cost per record. Histograms
+ * 				filled independently can be added up.
+ */
+class Histogram {
+private:
+	vector<unsigned long> counts;
+	unsigned long total;
+	unsigned long sum;
+	unsigned long min;
+	unsigned long max;
+	static int bucket(unsigned long value);
+	static unsigned long highest(int bucket);
+public:
+	Histogram();
+	virtual ~Histogram();
+	void record(unsigned long value);
+	void add(const Histogram &anotherHistogram);
+	unsigned long valueAt(double percentile);
+	unsigned long getCount();
+	unsigned long getMin();
+	unsigned long getMax();
+	double getMean();
+	void checkpoint(Checkpoint &cp);
+};
+
+#endif /* _HISTOGRAM_H_ */
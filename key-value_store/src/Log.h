@@ -10,6 +10,7 @@
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "Executor.h"
 
 /*
  * Macros
@@ -29,6 +30,13 @@ class Log{
 private:
 	Params *par;
 	bool firstTime;
+	FILE *fp;
+	FILE *fp2;
+	int numwrites;
+	// Lines logged by every task of the running phase while staging, see stage
+	vector< vector< pair<string, string> > > pending;
+	bool staging;
+	void write(const char *stdstring, const char *buffer);
 public:
 	Log(Params *p);
 	Log(const Log &anotherLog);
@@ -47,6 +55,8 @@ public:
 	void logReadFail(Address * address, bool isCoordinator, int transID, string key);
 	void logUpdateFail(Address * address, bool isCoordinator, int transID, string key, string newValue);
 	void logDeleteFail(Address * address, bool isCoordinator, int transID, string key);
+	void stage(int tasks);
+	void flush();
 };
 
 #endif /* _LOG_H_ */
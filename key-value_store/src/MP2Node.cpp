@@ -15,6 +15,9 @@ MP2Node::MP2Node(Member *memberNode, Params *par, EmulNet * emulNet, Log * log,
 	this->log = log;
 	ht = new HashTable();
 	this->memberNode->addr = *address;
+	memset(failed, 0, sizeof(failed));
+	firstStart = -1;
+	lastEnd = -1;
 }
 
 /**
@@ -52,11 +55,25 @@ void MP2Node::updateRing() {
 	// Sort the list based on the hashCode
 	sort(curMemList.begin(), curMemList.end());
 
+	if ( curMemList.size() != ring.size() ) {
+		change = true;
+	}
+	for ( unsigned int i = 0; !change && i < curMemList.size(); i++ ) {
+		if ( *curMemList[i].getAddress() != *ring[i].getAddress() ) {
+			change = true;
+		}
+	}
+	if ( change ) {
+		ring = curMemList;
+	}
 
 	/*
 	 * Step 3: Run the stabilization protocol IF REQUIRED
 	 */
 	// Run stabilization protocol if the hash table size is greater than zero and if there has been a changed in the ring
+	if ( change && !ht->hashTable.empty() ) {
+		stabilizationProtocol();
+	}
 }
 
 /**
@@ -108,9 +125,8 @@ size_t MP2Node::hashFunction(string key) {
  * 				3) Sends a message to the replica
  */
 void MP2Node::clientCreate(string key, string value) {
-	/*
-	 * Implement this
-	 */
+	Message message(g_transID++, memberNode->addr, CREATE, key, value);
+	dispatchMessages(message);
 }
 
 /**
@@ -123,9 +139,8 @@ void MP2Node::clientCreate(string key, string value) {
  * 				3) Sends a message to the replica
  */
 void MP2Node::clientRead(string key){
-	/*
-	 * Implement this
-	 */
+	Message message(g_transID++, memberNode->addr, READ, key);
+	dispatchMessages(message);
 }
 
 /**
@@ -138,9 +153,8 @@ void MP2Node::clientRead(string key){
  * 				3) Sends a message to the replica
  */
 void MP2Node::clientUpdate(string key, string value){
-	/*
-	 * Implement this
-	 */
+	Message message(g_transID++, memberNode->addr, UPDATE, key, value);
+	dispatchMessages(message);
 }
 
 /**
@@ -153,9 +167,44 @@ void MP2Node::clientUpdate(string key, string value){
  * 				3) Sends a message to the replica
  */
 void MP2Node::clientDelete(string key){
-	/*
-	 * Implement this
-	 */
+	Message message(g_transID++, memberNode->addr, DELETE, key);
+	dispatchMessages(message);
+}
+
+/**
+ * FUNCTION NAME: dispatchMessages
+ *
+ * DESCRIPTION: Coordinator side: open a transaction stamped with the current tick
+ * 				and send the message to the replicas of its key.
+ * 				The message is serialized once and the replicas share the buffer.
+ */
+void MP2Node::dispatchMessages(Message message) {
+	vector<Node> replicas = findNodes(message.key);
+	vector<Address> addrs;
+	kv_trans trans;
+
+	trans.type = message.type;
+	trans.key = message.key;
+	trans.value = message.value;
+	trans.start = par->getcurrtime();
+	trans.replicas = replicas.size();
+	trans.successes = 0;
+	trans.failures = 0;
+	if ( firstStart < 0 ) {
+		firstStart = trans.start;
+	}
+	map<int, kv_trans>::iterator it = transactions.insert(make_pair(message.transID, trans)).first;
+
+	if ( trans.replicas < QUORUM ) {
+		// not enough of a ring to ever reach quorum
+		completeTransaction(it, false);
+		return;
+	}
+
+	for ( unsigned int i = 0; i < replicas.size(); i++ ) {
+		addrs.push_back(*replicas[i].getAddress());
+	}
+	emulNet->ENsendMulti(&memberNode->addr, addrs, message.toString(), KV_CHANNEL);
 }
 
 /**
@@ -167,10 +216,9 @@ void MP2Node::clientDelete(string key){
  * 			   	2) Return true or false based on success or failure
  */
 bool MP2Node::createKeyValue(string key, string value, ReplicaType replica) {
-	/*
-	 * Implement this
-	 */
 	// Insert key, value, replicaType into the hash table
+	Entry entry(value, par->getcurrtime(), replica);
+	return ht->create(key, entry.convertToString());
 }
 
 /**
@@ -182,10 +230,14 @@ bool MP2Node::createKeyValue(string key, string value, ReplicaType replica) {
  * 			    2) Return value
  */
 string MP2Node::readKey(string key) {
-	/*
-	 * Implement this
-	 */
 	// Read key from local hash table and return value
+	string stored = ht->read(key);
+
+	if ( stored.empty() ) {
+		return "";
+	}
+	Entry entry(stored);
+	return entry.value;
 }
 
 /**
@@ -197,10 +249,9 @@ string MP2Node::readKey(string key) {
  * 				2) Return true or false based on success or failure
  */
 bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica) {
-	/*
-	 * Implement this
-	 */
 	// Update key in local hash table and return true or false
+	Entry entry(value, par->getcurrtime(), replica);
+	return ht->update(key, entry.convertToString());
 }
 
 /**
@@ -212,10 +263,214 @@ bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica) {
  * 				2) Return true or false based on success or failure
  */
 bool MP2Node::deletekey(string key) {
-	/*
-	 * Implement this
-	 */
 	// Delete the key from the local hash table
+	return ht->deleteKey(key);
+}
+
+/**
+ * FUNCTION NAME: replicaOf
+ *
+ * DESCRIPTION: Role of this node among the replicas of key, as far as its ring tells
+ */
+ReplicaType MP2Node::replicaOf(string key) {
+	vector<Node> replicas = findNodes(key);
+
+	for ( unsigned int i = 0; i < replicas.size(); i++ ) {
+		if ( *replicas[i].getAddress() == memberNode->addr ) {
+			return static_cast<ReplicaType>(i);
+		}
+	}
+	return PRIMARY;
+}
+
+/**
+ * FUNCTION NAME: handleRequest
+ *
+ * DESCRIPTION: Server side: apply a CRUD request to the local hash table and
+ * 				answer the coordinator
+ */
+void MP2Node::handleRequest(Message &message) {
+	bool success = false;
+	string value;
+
+	if ( message.transID == STABILIZE_TRANSID ) {
+		// a copy handed over after a ring change; a value already here is at least as new
+		createKeyValue(message.key, message.value, replicaOf(message.key));
+		return;
+	}
+
+	switch ( message.type ) {
+		case CREATE:
+			success = createKeyValue(message.key, message.value, replicaOf(message.key));
+			if ( success ) {
+				log->logCreateSuccess(&memberNode->addr, false, message.transID, message.key, message.value);
+			}
+			else {
+				log->logCreateFail(&memberNode->addr, false, message.transID, message.key, message.value);
+			}
+			break;
+		case READ:
+			value = readKey(message.key);
+			if ( !value.empty() ) {
+				log->logReadSuccess(&memberNode->addr, false, message.transID, message.key, value);
+			}
+			else {
+				log->logReadFail(&memberNode->addr, false, message.transID, message.key);
+			}
+			{
+				Message reply(message.transID, memberNode->addr, value);
+				emulNet->ENsend(&memberNode->addr, &message.fromAddr, reply.toString(), KV_CHANNEL);
+			}
+			return;
+		case UPDATE:
+			success = updateKeyValue(message.key, message.value, replicaOf(message.key));
+			if ( success ) {
+				log->logUpdateSuccess(&memberNode->addr, false, message.transID, message.key, message.value);
+			}
+			else {
+				log->logUpdateFail(&memberNode->addr, false, message.transID, message.key, message.value);
+			}
+			break;
+		default:
+			success = deletekey(message.key);
+			if ( success ) {
+				log->logDeleteSuccess(&memberNode->addr, false, message.transID, message.key);
+			}
+			else {
+				log->logDeleteFail(&memberNode->addr, false, message.transID, message.key);
+			}
+			break;
+	}
+
+	Message reply(message.transID, memberNode->addr, REPLY, success);
+	emulNet->ENsend(&memberNode->addr, &message.fromAddr, reply.toString(), KV_CHANNEL);
+}
+
+/**
+ * FUNCTION NAME: handleReply
+ *
+ * DESCRIPTION: Coordinator side: count a replica's answer and complete the
+ * 				transaction once a quorum agreed or can no longer agree
+ */
+void MP2Node::handleReply(Message &message, bool success) {
+	map<int, kv_trans>::iterator it = transactions.find(message.transID);
+
+	if ( it == transactions.end() ) {
+		// already completed, or timed out
+		return;
+	}
+
+	kv_trans &trans = it->second;
+	if ( success ) {
+		trans.successes++;
+		if ( message.type == READREPLY ) {
+			trans.value = message.value;
+		}
+	}
+	else {
+		trans.failures++;
+	}
+
+	if ( trans.successes >= QUORUM ) {
+		completeTransaction(it, true);
+	}
+	else if ( trans.replicas - trans.failures < QUORUM ) {
+		completeTransaction(it, false);
+	}
+}
+
+/**
+ * FUNCTION NAME: completeTransaction
+ *
+ * DESCRIPTION: Coordinator side: log the outcome of a transaction, record its
+ * 				latency from the client call and forget it
+ */
+void MP2Node::completeTransaction(map<int, kv_trans>::iterator it, bool success) {
+	int transID = it->first;
+	kv_trans &trans = it->second;
+	int now = par->getcurrtime();
+
+	switch ( trans.type ) {
+		case CREATE:
+			if ( success ) {
+				log->logCreateSuccess(&memberNode->addr, true, transID, trans.key, trans.value);
+			}
+			else {
+				log->logCreateFail(&memberNode->addr, true, transID, trans.key, trans.value);
+			}
+			break;
+		case READ:
+			if ( success ) {
+				log->logReadSuccess(&memberNode->addr, true, transID, trans.key, trans.value);
+			}
+			else {
+				log->logReadFail(&memberNode->addr, true, transID, trans.key);
+			}
+			break;
+		case UPDATE:
+			if ( success ) {
+				log->logUpdateSuccess(&memberNode->addr, true, transID, trans.key, trans.value);
+			}
+			else {
+				log->logUpdateFail(&memberNode->addr, true, transID, trans.key, trans.value);
+			}
+			break;
+		default:
+			if ( success ) {
+				log->logDeleteSuccess(&memberNode->addr, true, transID, trans.key);
+			}
+			else {
+				log->logDeleteFail(&memberNode->addr, true, transID, trans.key);
+			}
+			break;
+	}
+
+	latency[trans.type].record(now - trans.start);
+	if ( !success ) {
+		failed[trans.type]++;
+	}
+	lastEnd = now;
+	transactions.erase(it);
+}
+
+/**
+ * FUNCTION NAME: checkTimeouts
+ *
+ * DESCRIPTION: Coordinator side: fail the transactions that have waited KV_TIMEOUT
+ * 				ticks without reaching quorum
+ */
+void MP2Node::checkTimeouts() {
+	map<int, kv_trans>::iterator it = transactions.begin();
+	map<int, kv_trans>::iterator next;
+
+	while ( it != transactions.end() ) {
+		next = it;
+		++next;
+		if ( par->getcurrtime() - it->second.start >= par->KV_TIMEOUT ) {
+			completeTransaction(it, false);
+		}
+		it = next;
+	}
+}
+
+/**
+ * FUNCTION NAME: nextTimeout
+ *
+ * DESCRIPTION: Coordinator side: tick at which checkTimeouts fails the oldest
+ * 				open transaction
+ *
+ * RETURNS:
+ * -1 if this node coordinates no open transaction
+ */
+int MP2Node::nextTimeout() {
+	int next = -1;
+
+	for ( map<int, kv_trans>::iterator it = transactions.begin(); it != transactions.end(); ++it ) {
+		if ( next < 0 || it->second.start + par->KV_TIMEOUT < next ) {
+			next = it->second.start + par->KV_TIMEOUT;
+		}
+	}
+	return next;
 }
 
 /**
@@ -233,31 +488,41 @@ void MP2Node::checkMessages() {
 	char * data;
 	int size;
 
-	/*
-	 * Declare your local variables here
-	 */
 
-	// dequeue all messages and handle them
-	while ( !memberNode->mp2q.empty() ) {
+	// handle the whole batch of received messages
+	for ( unsigned int i = 0; i < memberNode->mp2q.size(); i++ ) {
 		/*
-		 * Pop a message from the queue
+		 * Take a message from the batch
 		 */
-		data = (char *)memberNode->mp2q.front().elt;
-		size = memberNode->mp2q.front().size;
-		memberNode->mp2q.pop();
+		data = (char *)memberNode->mp2q[i].elt;
+		size = memberNode->mp2q[i].size;
 
 		string message(data, data + size);
+		emulNet->ENfree(data);
 
 		/*
 		 * Handle the message types here
 		 */
-
+		Message msg(message);
+		switch ( msg.type ) {
+			case REPLY:
+				handleReply(msg, msg.success);
+				break;
+			case READREPLY:
+				handleReply(msg, !msg.value.empty());
+				break;
+			default:
+				handleRequest(msg);
+				break;
+		}
 	}
+	memberNode->mp2q.clear();
 
 	/*
 	 * This function should also ensure all READ and UPDATE operation
 	 * get QUORUM replies
 	 */
+	checkTimeouts();
 }
 
 /**
@@ -295,25 +560,18 @@ vector<Node> MP2Node::findNodes(string key) {
 /**
  * FUNCTION NAME: recvLoop
  *
- * DESCRIPTION: Receive messages from EmulNet and push into the queue (mp2q)
+ * DESCRIPTION: Receive messages from EmulNet in one pass and push each into the queue
+ * 				of its channel: membership messages into mp1q, KV store ones into mp2q
  */
 bool MP2Node::recvLoop() {
+    vector<q_elt> *queues[EN_CHANNELS];
+
     if ( memberNode->bFailed ) {
     	return false;
     }
-    else {
-    	return emulNet->ENrecv(&(memberNode->addr), this->enqueueWrapper, NULL, 1, &(memberNode->mp2q));
-    }
-}
-
-/**
- * FUNCTION NAME: enqueueWrapper
- *
- * DESCRIPTION: Enqueue the message from Emulnet into the queue of MP2Node
- */
-int MP2Node::enqueueWrapper(void *env, char *buff, int size) {
-	Queue q;
-	return q.enqueue((queue<q_elt> *)env, (void *)buff, size);
+    queues[MEMBERSHIP_CHANNEL] = &memberNode->mp1q;
+    queues[KV_CHANNEL] = &memberNode->mp2q;
+    return emulNet->ENrecvBatch(&(memberNode->addr), queues);
 }
 /**
  * FUNCTION NAME: stabilizationProtocol
@@ -325,7 +583,122 @@ int MP2Node::enqueueWrapper(void *env, char *buff, int size) {
  *				Note:- "CORRECT" replicas implies that every key is replicated in its two neighboring nodes in the ring
  */
 void MP2Node::stabilizationProtocol() {
-	/*
-	 * Implement this
-	 */
+	vector<string> handedOver;
+
+	for ( map<string, string>::iterator it = ht->hashTable.begin(); it != ht->hashTable.end(); ++it ) {
+		vector<Node> replicas = findNodes(it->first);
+		vector<Address> addrs;
+		bool mine = false;
+
+		if ( replicas.empty() ) {
+			// no ring to place the key on yet, keep it
+			continue;
+		}
+		for ( unsigned int i = 0; i < replicas.size(); i++ ) {
+			if ( *replicas[i].getAddress() == memberNode->addr ) {
+				mine = true;
+			}
+			else {
+				addrs.push_back(*replicas[i].getAddress());
+			}
+		}
+
+		// every holder sends its copy to the other replicas, which keep the first one
+		Entry entry(it->second);
+		Message message(STABILIZE_TRANSID, memberNode->addr, CREATE, it->first, entry.value);
+		emulNet->ENsendMulti(&memberNode->addr, addrs, message.toString(), KV_CHANNEL);
+		if ( !mine ) {
+			handedOver.push_back(it->first);
+		}
+	}
+
+	// keys this node is no longer a replica of, so a later ring change cannot bring back a stale copy
+	for ( unsigned int i = 0; i < handedOver.size(); i++ ) {
+		deletekey(handedOver[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: checkpointNodes
+ *
+ * DESCRIPTION: Save or restore a list of nodes by address, the hash codes follow from it
+ */
+static void checkpointNodes(Checkpoint &cp, vector<Node> &nodes) {
+	vector<Address> addrs;
+
+	for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+		addrs.push_back(*nodes[i].getAddress());
+	}
+	cp.io(addrs);
+	if ( !cp.saving() ) {
+		nodes.clear();
+		for ( unsigned int i = 0; i < addrs.size(); i++ ) {
+			nodes.push_back(Node(addrs[i]));
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: checkpointTrans
+ *
+ * DESCRIPTION: Save or restore an operation this node coordinates
+ */
+static void checkpointTrans(Checkpoint &cp, kv_trans &trans) {
+	cp.io(trans.type);
+	cp.io(trans.key);
+	cp.io(trans.value);
+	cp.io(trans.start);
+	cp.io(trans.replicas);
+	cp.io(trans.successes);
+	cp.io(trans.failures);
+}
+
+/**
+ * FUNCTION NAME: checkpoint
+ *
+ * DESCRIPTION: Save or restore the ring, the hash table, the operations this node
+ * 				coordinates, its latency histograms and the KV messages it has not
+ * 				handled yet
+ */
+void MP2Node::checkpoint(Checkpoint &cp) {
+	int count = transactions.size();
+	int transID;
+
+	checkpointNodes(cp, ring);
+	checkpointNodes(cp, hasMyReplicas);
+	checkpointNodes(cp, haveReplicasOf);
+	cp.io(ht->hashTable);
+
+	cp.io(count);
+	if ( cp.saving() ) {
+		for ( map<int, kv_trans>::iterator it = transactions.begin(); it != transactions.end(); ++it ) {
+			transID = it->first;
+			cp.io(transID);
+			checkpointTrans(cp, it->second);
+		}
+	}
+	else {
+		transactions.clear();
+		for ( int i = 0; i < count && cp.ok(); i++ ) {
+			cp.io(transID);
+			checkpointTrans(cp, transactions[transID]);
+		}
+	}
+
+	for ( int type = CREATE; type <= DELETE; type++ ) {
+		latency[type].checkpoint(cp);
+	}
+	cp.io(failed);
+	cp.io(firstStart);
+	cp.io(lastEnd);
+	emulNet->ENcheckpoint(cp, memberNode->mp2q);
+}
+
+/**
+ * FUNCTION NAME: checkpointShared
+ *
+ * DESCRIPTION: Save or restore the transaction counter all the coordinators draw from
+ */
+void MP2Node::checkpointShared(Checkpoint &cp) {
+	cp.io(g_transID);
 }
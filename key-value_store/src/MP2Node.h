@@ -17,7 +17,35 @@
 #include "Log.h"
 #include "Params.h"
 #include "Message.h"
-#include "Queue.h"
+#include "Histogram.h"
+
+/*
+ * Macros
+ */
+// Replicas that have to agree before an operation succeeds
+#define QUORUM 2
+// transID of the copies the stabilization protocol hands out; replicas store
+// them without logging or answering, no client is waiting on them
+#define STABILIZE_TRANSID -1
+#define LATENCY_LOG "latency.log"
+
+/**
+ * Struct Name: kv_trans
+ *
+ * DESCRIPTION: An operation this node coordinates, from the client call until
+ * 				a quorum of its replicas agreed, or could no longer agree
+ */
+typedef struct kv_trans {
+	MessageType type;
+	string key;
+	string value;
+	// Tick of the client call
+	int start;
+	// Replicas the operation went to, and their answers so far
+	int replicas;
+	int successes;
+	int failures;
+}kv_trans;
 
 /**
  * CLASS NAME: MP2Node
@@ -47,6 +75,20 @@ private:
 	EmulNet * emulNet;
 	// Object of Log
 	Log * log;
+	// Operations coordinated by this node that have not completed, by transID
+	map<int, kv_trans> transactions;
+	// Latency in ticks of the operations this node completed as coordinator,
+	// and the number of them that failed, per MessageType from CREATE to DELETE
+	Histogram latency[DELETE + 1];
+	unsigned long failed[DELETE + 1];
+	// Tick of the first client call and of the last completion, -1 before any
+	int firstStart;
+	int lastEnd;
+	void handleRequest(Message &message);
+	void handleReply(Message &message, bool success);
+	void completeTransaction(map<int, kv_trans>::iterator it, bool success);
+	void checkTimeouts();
+	ReplicaType replicaOf(string key);
 
 public:
 	MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Address *addressOfMember);
@@ -68,7 +110,6 @@ public:
 
 	// receive messages from Emulnet
 	bool recvLoop();
-	static int enqueueWrapper(void *env, char *buff, int size);
 
 	// handle messages from receiving queue
 	void checkMessages();
@@ -88,6 +129,27 @@ public:
 	// stabilization protocol - handle multiple failures
 	void stabilizationProtocol();
 
+	// tick the earliest operation this node coordinates times out at, -1 if none
+	int nextTimeout();
+
+	// latency of the operations this node coordinated
+	Histogram & getLatency(MessageType type) {
+		return latency[type];
+	}
+	unsigned long getFailed(MessageType type) {
+		return failed[type];
+	}
+	int getFirstStart() {
+		return firstStart;
+	}
+	int getLastEnd() {
+		return lastEnd;
+	}
+
+	// save or restore the state of this node, and the state all nodes share
+	void checkpoint(Checkpoint &cp);
+	static void checkpointShared(Checkpoint &cp);
+
 	~MP2Node();
 };
 
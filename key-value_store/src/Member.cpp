@@ -31,8 +31,19 @@ Address& Address::operator =(const Address& anotherAddress) {
 /**
  * Compare two Address objects
  */
-bool Address::operator ==(const Address& anotherAddress) {
-	return !memcmp(this->addr, anotherAddress.addr, sizeof(this->addr));
+bool Address::operator ==(const Address& anotherAddress) const {
+	return getNodeId() == anotherAddress.getNodeId();
+}
+
+bool Address::operator !=(const Address& anotherAddress) const {
+	return getNodeId() != anotherAddress.getNodeId();
+}
+
+/**
+ * Order Address objects by node id
+ */
+bool Address::operator <(const Address& anotherAddress) const {
+	return getNodeId() < anotherAddress.getNodeId();
 }
 
 /**
@@ -85,6 +96,15 @@ short MemberListEntry::getport() {
 	return port;
 }
 
+/**
+ * FUNCTION NAME: getnodeid
+ *
+ * DESCRIPTION: Packed id and port of the member
+ */
+NodeId MemberListEntry::getnodeid() {
+	return makeNodeId(id, port);
+}
+
 /**
  * FUNCTION NAME: getheartbeat
  *
@@ -8,6 +8,27 @@
 #define MEMBER_H_
 
 #include "stdincludes.h"
+#include <stdint.h>
+
+/*
+ * Packed node identifier: the id in the upper bits and the port in the lower
+ * 16 bits, so equality, ordering and hashing are single integer operations
+ */
+typedef uint64_t NodeId;
+
+inline NodeId makeNodeId(int id, short port) {
+	return ((NodeId)(uint32_t)id << 16) | (uint16_t)port;
+}
+
+/*
+ * Mix all the bits of a NodeId; consecutive ids must not land next to each other on the ring
+ */
+inline size_t hashNodeId(NodeId nodeId) {
+	nodeId += 0x9e3779b97f4a7c15ULL;
+	nodeId = (nodeId ^ (nodeId >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	nodeId = (nodeId ^ (nodeId >> 27)) * 0x94d049bb133111ebULL;
+	return (size_t)(nodeId ^ (nodeId >> 31));
+}
 
 /**
  * CLASS NAME: q_elt
@@ -34,7 +55,9 @@ public:
 	Address(const Address &anotherAddress);
 	 // Overloaded = operator
 	Address& operator =(const Address &anotherAddress);
-	bool operator ==(const Address &anotherAddress);
+	bool operator ==(const Address &anotherAddress) const;
+	bool operator !=(const Address &anotherAddress) const;
+	bool operator <(const Address &anotherAddress) const;
 	Address(string address) {
 		size_t pos = address.find(":");
 		int id = stoi(address.substr(0, pos));
@@ -49,11 +72,29 @@ public:
 		memcpy(&port, &addr[4], sizeof(short));
 		return to_string(id) + ":" + to_string(port);
 	}
+	NodeId getNodeId() const {
+		int id;
+		short port;
+		memcpy(&id, &addr[0], sizeof(int));
+		memcpy(&port, &addr[4], sizeof(short));
+		return makeNodeId(id, port);
+	}
 	void init() {
 		memset(&addr, 0, sizeof(addr));
 	}
 };
 
+/*
+ * Lets Address be the key of an unordered container
+ */
+namespace std {
+	template <> struct hash<Address> {
+		size_t operator()(const Address &address) const {
+			return hashNodeId(address.getNodeId());
+		}
+	};
+}
+
 /**
  * CLASS NAME: MemberListEntry
  *
@@ -72,6 +113,7 @@ public:
 	MemberListEntry& operator =(const MemberListEntry &anotherMLE);
 	int getid();
 	short getport();
+	NodeId getnodeid();
 	long getheartbeat();
 	long gettimestamp();
 	void setid(int id);
@@ -109,9 +151,9 @@ public:
 	// My position in the membership table
 	vector<MemberListEntry>::iterator myPos;
 	// Queue for failure detection messages
-	queue<q_elt> mp1q;
+	vector<q_elt> mp1q;
 	// Queue for KVstore messages
-	queue<q_elt> mp2q;
+	vector<q_elt> mp2q;
 	/**
 	 * Constructor
 	 */
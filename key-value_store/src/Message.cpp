@@ -93,6 +93,8 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
 	type = _type;
 	key = _key;
 	value = _value;
+	// the replicas share one payload, each one works out its role from the ring
+	replica = PRIMARY;
 }
 
 /**
@@ -0,0 +1,159 @@
+/**********************************
+ * FILE NAME: MsgPool.cpp
+ *
+ * DESCRIPTION: Definition of the size-class message pool used by EmulNet
+ **********************************/
+
+#include "MsgPool.h"
+
+/**
+ * Constructor
+ */
+MsgPool::MsgPool(): allocs(0), hits(0), bytesInUse(0), peakBytes(0), bytesReserved(0) {}
+
+/**
+ * Destructor
+ */
+MsgPool::~MsgPool() {
+	for ( unsigned int i = 0; i < slabs.size(); i++ ) {
+		free(slabs[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: sizeClass
+ *
+ * DESCRIPTION: Smallest size class whose blocks hold size bytes plus the header
+ *
+ * RETURNS:
+ * POOL_NUM_CLASSES if the request is larger than the largest class
+ */
+int MsgPool::sizeClass(size_t size) {
+	size_t block = POOL_MIN_BLOCK;
+	int sizeclass = 0;
+
+	while ( sizeclass < POOL_NUM_CLASSES && block < size + sizeof(pool_hdr) ) {
+		block <<= 1;
+		sizeclass++;
+	}
+	return sizeclass;
+}
+
+/**
+ * FUNCTION NAME: addSlab
+ *
+ * DESCRIPTION: Carve a new slab into blocks of the given class and put them on its free list
+ */
+void MsgPool::addSlab(int sizeclass) {
+	size_t block = (size_t)POOL_MIN_BLOCK << sizeclass;
+	char *slab = (char *) malloc(block * POOL_SLAB_BLOCKS);
+
+	slabs.push_back(slab);
+	bytesReserved += block * POOL_SLAB_BLOCKS;
+	for ( int i = POOL_SLAB_BLOCKS - 1; i >= 0; i-- ) {
+		freeList[sizeclass].push_back(slab + i * block);
+	}
+}
+
+/**
+ * FUNCTION NAME: allocate
+ *
+ * DESCRIPTION: Hand out a block of at least size bytes
+ */
+void *MsgPool::allocate(size_t size) {
+	int sizeclass = sizeClass(size);
+	pool_hdr *hdr;
+
+	allocs++;
+	if ( sizeclass == POOL_NUM_CLASSES ) {
+		// Too large for any class, fall back to the heap
+		hdr = (pool_hdr *) malloc(sizeof(pool_hdr) + size);
+		bytesInUse += sizeof(pool_hdr) + size;
+	}
+	else {
+		if ( freeList[sizeclass].empty() ) {
+			addSlab(sizeclass);
+		}
+		else {
+			hits++;
+		}
+		hdr = (pool_hdr *) freeList[sizeclass].back();
+		freeList[sizeclass].pop_back();
+		bytesInUse += (size_t)POOL_MIN_BLOCK << sizeclass;
+	}
+
+	hdr->sizeclass = sizeclass;
+	hdr->size = size;
+	if ( bytesInUse > peakBytes ) {
+		peakBytes = bytesInUse;
+	}
+	return hdr + 1;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Give a block back to the free list of its class
+ */
+void MsgPool::release(void *ptr) {
+	if ( ptr == NULL ) {
+		return;
+	}
+
+	pool_hdr *hdr = (pool_hdr *)ptr - 1;
+
+	if ( hdr->sizeclass == POOL_NUM_CLASSES ) {
+		bytesInUse -= sizeof(pool_hdr) + hdr->size;
+		free(hdr);
+	}
+	else {
+		bytesInUse -= (size_t)POOL_MIN_BLOCK << hdr->sizeclass;
+		freeList[hdr->sizeclass].push_back(hdr);
+	}
+}
+
+/**
+ * FUNCTION NAME: getHitRate
+ *
+ * DESCRIPTION: Fraction of allocations that were served from a free list
+ */
+double MsgPool::getHitRate() {
+	return allocs ? (double)hits / allocs : 0.0;
+}
+
+/**
+ * FUNCTION NAME: getAllocs
+ *
+ * DESCRIPTION: getter
+ */
+unsigned long MsgPool::getAllocs() {
+	return allocs;
+}
+
+/**
+ * FUNCTION NAME: getPeakBytes
+ *
+ * DESCRIPTION: getter
+ */
+unsigned long MsgPool::getPeakBytes() {
+	return peakBytes;
+}
+
+/**
+ * FUNCTION NAME: getBytesReserved
+ *
+ * DESCRIPTION: getter
+ */
+unsigned long MsgPool::getBytesReserved() {
+	return bytesReserved;
+}
+
+/**
+ * FUNCTION NAME: printStats
+ *
+ * DESCRIPTION: Print the pool counters to the given file
+ */
+void MsgPool::printStats(FILE *file) {
+	fprintf(file, "pool allocs %lu hits %lu hit_rate %.4f\n", allocs, hits, getHitRate());
+	fprintf(file, "pool peak_bytes %lu reserved_bytes %lu slabs %lu\n", peakBytes, bytesReserved, (unsigned long)slabs.size());
+}
@@ -0,0 +1,74 @@
+/**********************************
+ * FILE NAME: MsgPool.h
+ *
+ * DESCRIPTION: Header file of the size-class message pool used by EmulNet
+ **********************************/
+
+#ifndef _MSGPOOL_H_
+#define _MSGPOOL_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Smallest block handed out by the pool, header included
+#define POOL_MIN_BLOCK 64
+// Block sizes double from POOL_MIN_BLOCK up to POOL_MIN_BLOCK << (POOL_NUM_CLASSES - 1)
+#define POOL_NUM_CLASSES 8
+// Number of blocks carved out of one slab
+#define POOL_SLAB_BLOCKS 64
+
+/**
+ * Struct Name: pool_hdr
+ *
+ * DESCRIPTION: Header in front of every block; records where the block goes back to
+ */
+typedef struct pool_hdr {
+	// Size class of the block, POOL_NUM_CLASSES for blocks too large for any class
+	size_t sizeclass;
+	// Number of bytes the caller asked for
+	size_t size;
+}pool_hdr;
+
+/**
+ * CLASS NAME: MsgPool
+ *
+ * DESCRIPTION: Slab allocator for network messages. Blocks are grouped into
+ * 				power-of-two size classes, carved out of slabs of
+ * 				POOL_SLAB_BLOCKS blocks and recycled through a free list
+ * 				per class as soon as they are released, so the steady state
+ * 				of a run does no malloc/free per message.
+ */
+class MsgPool {
+private:
+	vector<void *> freeList[POOL_NUM_CLASSES];
+	vector<char *> slabs;
+	// Number of allocate() calls
+	unsigned long allocs;
+	// Number of allocate() calls served from a free list
+	unsigned long hits;
+	// Bytes of blocks currently handed out
+	unsigned long bytesInUse;
+	// High-water mark of bytesInUse
+	unsigned long peakBytes;
+	// Bytes held in slabs
+	unsigned long bytesReserved;
+	int sizeClass(size_t size);
+	void addSlab(int sizeclass);
+public:
+	MsgPool();
+	// Blocks belong to the slabs of the pool that carved them, so a pool is never copied
+	MsgPool(const MsgPool &anotherPool) = delete;
+	MsgPool& operator =(const MsgPool &anotherPool) = delete;
+	virtual ~MsgPool();
+	void *allocate(size_t size);
+	void release(void *ptr);
+	double getHitRate();
+	unsigned long getAllocs();
+	unsigned long getPeakBytes();
+	unsigned long getBytesReserved();
+	void printStats(FILE *file);
+};
+
+#endif /* _MSGPOOL_H_ */
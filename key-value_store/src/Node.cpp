@@ -30,7 +30,7 @@ Node::~Node() {}
  * DESCRIPTION: This function computes the hash code of the node address
  */
 void Node::computeHashCode() {
-	nodeHashCode = hashFunc(nodeAddress.addr)%RING_SIZE;
+	nodeHashCode = hashNodeId(nodeAddress.getNodeId())%RING_SIZE;
 }
 
 /**
@@ -54,7 +54,11 @@ Node& Node::operator=(const Node& another) {
  * operator overloading
  */
 bool Node::operator < (const Node& another) const {
-	return this->nodeHashCode < another.nodeHashCode;
+	// ties on the ring are broken by node id so every node sorts the ring the same way
+	if ( this->nodeHashCode != another.nodeHashCode ) {
+		return this->nodeHashCode < another.nodeHashCode;
+	}
+	return getNodeId() < another.getNodeId();
 }
 
 /**
@@ -75,6 +79,15 @@ Address * Node::getAddress() {
 	return &nodeAddress;
 }
 
+/**
+ * FUNCTION NAME: getNodeId
+ *
+ * DESCRIPTION: return the packed id of the node
+ */
+NodeId Node::getNodeId() const {
+	return nodeAddress.getNodeId();
+}
+
 /**
  * FUNCTION NAME: setHashCode
  *
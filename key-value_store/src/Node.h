@@ -14,7 +14,6 @@ class Node {
 public:
 	Address nodeAddress;
 	size_t nodeHashCode;
-	std::hash<string> hashFunc;
 	Node();
 	Node(Address address);
 	Node(const Node& another);
@@ -23,6 +22,7 @@ public:
 	void computeHashCode();
 	size_t getHashCode();
 	Address * getAddress();
+	NodeId getNodeId() const;
 	void setHashCode(size_t hashCode);
 	void setAddress(Address address);
 	virtual ~Node();
@@ -27,6 +27,45 @@ void Params::setparams(char *config_file) {
 	fscanf(fp,"\nMSG_DROP_PROB: %lf", &MSG_DROP_PROB);
 	fscanf(fp,"\nCRUD_TEST: %s", CRUD);
 
+	// Optional settings follow the fixed ones, one "KEY: value" per line
+	EN_BUFFSIZE = 0;
+	EN_NODEBUFFSIZE = 0;
+	LATENCY_MODEL = NO_LATENCY;
+	LATENCY_MIN = 0;
+	LATENCY_MAX = 0;
+	LATENCY_ALPHA = 2;
+	EGRESS_BANDWIDTH = 0;
+	TRANSPORT = EMUL_TRANSPORT;
+	THREADS = 1;
+	SEED = 0;
+	TOTAL_RUNNING_TIME = 700;
+	MAX_MSG_SIZE = 4000;
+	DETAILED_LOGS = 1;
+	DELTA_GOSSIP = 0;
+	FULL_SYNC_INTERVAL = 10;
+	KV_TIMEOUT = 10;
+	BOOTSTRAP = 0;
+	CHECKPOINT_SAVE[0] = '\0';
+	CHECKPOINT_LOAD[0] = '\0';
+	CHECKPOINT_TIME = -1;
+	WL_RECORDS = 1000;
+	WL_KEY_MIN = 5;
+	WL_KEY_MAX = 5;
+	WL_VALUE_MIN = 10;
+	WL_VALUE_MAX = 100;
+	WL_SIZE_DIST = UNIFORM_SIZE;
+	WL_ACCESS = ZIPFIAN_ACCESS;
+	WL_ZIPF_THETA = 0.99;
+	WL_READ = 0.95;
+	WL_UPDATE = 0.05;
+	WL_INSERT = 0;
+	WL_DELETE = 0;
+	WL_OPS_PER_TICK = 10;
+	char key[64], value[64];
+	while ( fscanf(fp, " %63[^:]: %63s", key, value) == 2 ) {
+		setparam(key, value);
+	}
+
 	if ( 0 == strcmp(CRUD, "CREATE") ) {
 		this->CRUDTEST = CREATE_TEST;
 	}
@@ -39,12 +78,14 @@ void Params::setparams(char *config_file) {
 	else if ( 0 == strcmp(CRUD, "DELETE") ) {
 		this->CRUDTEST = DELETE_TEST;
 	}
+	else if ( 0 == strcmp(CRUD, "WORKLOAD") ) {
+		this->CRUDTEST = WORKLOAD_TEST;
+	}
 
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
 	EN_GPSZ = MAX_NNB;
 	STEP_RATE=.25;
-	MAX_MSG_SIZE = 4000;
 	globaltime = 0;
 	dropmsg = 0;
 	allNodesJoined = 0;
@@ -56,6 +97,151 @@ void Params::setparams(char *config_file) {
 	return;
 }
 
+/**
+ * FUNCTION NAME: setparam
+ *
+ * DESCRIPTION: Set one optional parameter read from the test case
+ */
+void Params::setparam(char *key, char *value) {
+	if ( 0 == strcmp(key, "EN_BUFFSIZE") ) {
+		EN_BUFFSIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "EN_NODEBUFFSIZE") ) {
+		EN_NODEBUFFSIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "LATENCY_MODEL") ) {
+		if ( 0 == strcmp(value, "FIXED") ) {
+			LATENCY_MODEL = FIXED_LATENCY;
+		}
+		else if ( 0 == strcmp(value, "UNIFORM") ) {
+			LATENCY_MODEL = UNIFORM_LATENCY;
+		}
+		else if ( 0 == strcmp(value, "LONGTAIL") ) {
+			LATENCY_MODEL = LONGTAIL_LATENCY;
+		}
+		else {
+			LATENCY_MODEL = NO_LATENCY;
+		}
+	}
+	else if ( 0 == strcmp(key, "LATENCY_MIN") ) {
+		LATENCY_MIN = atof(value);
+	}
+	else if ( 0 == strcmp(key, "LATENCY_MAX") ) {
+		LATENCY_MAX = atof(value);
+	}
+	else if ( 0 == strcmp(key, "LATENCY_ALPHA") ) {
+		LATENCY_ALPHA = atof(value);
+	}
+	else if ( 0 == strcmp(key, "EGRESS_BANDWIDTH") ) {
+		EGRESS_BANDWIDTH = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "TRANSPORT") ) {
+		if ( 0 == strcmp(value, "UDP") ) {
+			TRANSPORT = UDP_TRANSPORT;
+		}
+		else if ( 0 == strcmp(value, "SHM") ) {
+			TRANSPORT = SHM_TRANSPORT;
+		}
+		else {
+			TRANSPORT = EMUL_TRANSPORT;
+		}
+	}
+	else if ( 0 == strcmp(key, "THREADS") ) {
+		THREADS = atoi(value) > 0 ? atoi(value) : 1;
+	}
+	else if ( 0 == strcmp(key, "SEED") ) {
+		SEED = strtoul(value, NULL, 10);
+	}
+	else if ( 0 == strcmp(key, "TOTAL_RUNNING_TIME") ) {
+		TOTAL_RUNNING_TIME = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "MAX_MSG_SIZE") ) {
+		MAX_MSG_SIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "DETAILED_LOGS") ) {
+		DETAILED_LOGS = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "DELTA_GOSSIP") ) {
+		DELTA_GOSSIP = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "FULL_SYNC_INTERVAL") ) {
+		FULL_SYNC_INTERVAL = atoi(value) > 0 ? atoi(value) : 10;
+	}
+	else if ( 0 == strcmp(key, "KV_TIMEOUT") ) {
+		KV_TIMEOUT = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "BOOTSTRAP") ) {
+		BOOTSTRAP = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "CHECKPOINT_SAVE") ) {
+		snprintf(CHECKPOINT_SAVE, sizeof(CHECKPOINT_SAVE), "%s", value);
+	}
+	else if ( 0 == strcmp(key, "CHECKPOINT_LOAD") ) {
+		snprintf(CHECKPOINT_LOAD, sizeof(CHECKPOINT_LOAD), "%s", value);
+	}
+	else if ( 0 == strcmp(key, "CHECKPOINT_TIME") ) {
+		CHECKPOINT_TIME = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "WL_RECORDS") ) {
+		WL_RECORDS = atol(value);
+	}
+	else if ( 0 == strcmp(key, "WL_KEY_MIN") ) {
+		WL_KEY_MIN = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "WL_KEY_MAX") ) {
+		WL_KEY_MAX = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "WL_VALUE_MIN") ) {
+		WL_VALUE_MIN = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "WL_VALUE_MAX") ) {
+		WL_VALUE_MAX = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "WL_SIZE_DIST") ) {
+		if ( 0 == strcmp(value, "CONSTANT") ) {
+			WL_SIZE_DIST = CONSTANT_SIZE;
+		}
+		else if ( 0 == strcmp(value, "ZIPFIAN") ) {
+			WL_SIZE_DIST = ZIPFIAN_SIZE;
+		}
+		else {
+			WL_SIZE_DIST = UNIFORM_SIZE;
+		}
+	}
+	else if ( 0 == strcmp(key, "WL_ACCESS") ) {
+		if ( 0 == strcmp(value, "UNIFORM") ) {
+			WL_ACCESS = UNIFORM_ACCESS;
+		}
+		else if ( 0 == strcmp(value, "LATEST") ) {
+			WL_ACCESS = LATEST_ACCESS;
+		}
+		else {
+			WL_ACCESS = ZIPFIAN_ACCESS;
+		}
+	}
+	else if ( 0 == strcmp(key, "WL_ZIPF_THETA") ) {
+		WL_ZIPF_THETA = atof(value);
+	}
+	else if ( 0 == strcmp(key, "WL_READ") ) {
+		WL_READ = atof(value);
+	}
+	else if ( 0 == strcmp(key, "WL_UPDATE") ) {
+		WL_UPDATE = atof(value);
+	}
+	else if ( 0 == strcmp(key, "WL_INSERT") ) {
+		WL_INSERT = atof(value);
+	}
+	else if ( 0 == strcmp(key, "WL_DELETE") ) {
+		WL_DELETE = atof(value);
+	}
+	else if ( 0 == strcmp(key, "WL_OPS_PER_TICK") ) {
+		WL_OPS_PER_TICK = atof(value);
+	}
+	else {
+		printf("Ignoring unknown parameter %s\n", key);
+	}
+}
+
 /**
  * FUNCTION NAME: getcurrtime
  *
@@ -11,7 +11,11 @@
 #include "Params.h"
 #include "Member.h"
 
-enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST };
+enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST, WORKLOAD_TEST };
+enum latencyTYPE { NO_LATENCY, FIXED_LATENCY, UNIFORM_LATENCY, LONGTAIL_LATENCY };
+enum transportTYPE { EMUL_TRANSPORT, UDP_TRANSPORT, SHM_TRANSPORT };
+enum accessTYPE { UNIFORM_ACCESS, ZIPFIAN_ACCESS, LATEST_ACCESS };
+enum sizeTYPE { CONSTANT_SIZE, UNIFORM_SIZE, ZIPFIAN_SIZE };
 
 /**
  * CLASS NAME: Params
@@ -32,8 +36,43 @@ public:
 	int allNodesJoined;
 	short PORTNUM;
 	int CRUDTEST;
+	int EN_BUFFSIZE;			// max messages in flight across the network, 0 for no limit
+	int EN_NODEBUFFSIZE;		// max messages waiting for a single node, 0 for no limit
+	int LATENCY_MODEL;			// link latency distribution, see latencyTYPE
+	double LATENCY_MIN;			// fixed latency, lower bound or Pareto scale, in ticks
+	double LATENCY_MAX;			// upper bound of the latency, in ticks, 0 for no cap on the long tail
+	double LATENCY_ALPHA;		// Pareto shape of the long-tail latency
+	int EGRESS_BANDWIDTH;		// bytes a node can put on the wire per tick, 0 for no limit
+	int TRANSPORT;				// in-memory, loopback UDP or shared memory network, see transportTYPE
+	int THREADS;				// threads running the per-node tasks of a tick
+	unsigned int SEED;			// seed of the random number generators, 0 to seed from the clock
+	int TOTAL_RUNNING_TIME;		// ticks to run
+	int DETAILED_LOGS;			// per-tick message counts and member list dumps, 0 to keep only totals
+	int DELTA_GOSSIP;			// 1 to have PINGs carry only the members changed since their targets were last sent to
+	int FULL_SYNC_INTERVAL;		// with DELTA_GOSSIP, ticks between two PINGs carrying the whole membership list
+	int KV_TIMEOUT;				// ticks a coordinator waits for a quorum before failing the operation
+	int BOOTSTRAP;				// 1 to start every node in the group with the full membership, 0 to join through the introducer
+	// Checkpoints, see Application::checkpoint
+	char CHECKPOINT_SAVE[64];	// file to save the simulation to, empty for none
+	char CHECKPOINT_LOAD[64];	// file to restore the simulation from and go on, empty to start from scratch
+	int CHECKPOINT_TIME;		// tick at whose start to save, -1 for INSERT_TIME
+	// Workload of CRUD_TEST: WORKLOAD, see Workload
+	long WL_RECORDS;			// keys created by the load phase
+	int WL_KEY_MIN;				// key length bounds, in characters
+	int WL_KEY_MAX;
+	int WL_VALUE_MIN;			// value length bounds, in characters
+	int WL_VALUE_MAX;
+	int WL_SIZE_DIST;			// distribution of key and value lengths within their bounds, see sizeTYPE
+	int WL_ACCESS;				// which keys operations go to, see accessTYPE
+	double WL_ZIPF_THETA;		// skew of the zipfian distributions, below 1
+	double WL_READ;				// operation mix, relative weights
+	double WL_UPDATE;
+	double WL_INSERT;
+	double WL_DELETE;
+	double WL_OPS_PER_TICK;		// operations issued per tick, fractions carry over
 	Params();
 	void setparams(char *);
+	void setparam(char *key, char *value);
 	int getcurrtime();
 };
 
@@ -0,0 +1,74 @@
+/**********************************
+ * FILE NAME: UdpNet.h
+ *
+ * DESCRIPTION: Header file of the loopback UDP transport
+ **********************************/
+
+#ifndef _UDPNET_H_
+#define _UDPNET_H_
+
+#include "stdincludes.h"
+#include "EmulNet.h"
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/*
+ * Macros
+ */
+// Bytes of addressing and channel in front of the payload of every datagram
+#define UDP_HDRSIZE (2 * sizeof(Address) + sizeof(int))
+// Receive buffer asked for on every socket
+#define UDP_RCVBUF (1 << 20)
+// Ready sockets handled per epoll_wait call
+#define UDP_MAXEVENTS 64
+// Largest payload of a UDP datagram over IPv4
+#define UDP_MAXDATAGRAM 65507
+// epoll tag of the timer ENwait sleeps on, never a node id
+#define UDP_TIMER_TAG 0xffffffffU
+
+/**
+ * CLASS NAME: UdpNet
+ *
+ * DESCRIPTION: EmulNet that moves messages over real UDP sockets on the
+ * 				loopback interface instead of the in-memory store. Every node id
+ * 				gets a non-blocking socket bound to 127.0.0.1 at basePort + id
+ * 				(or at the port carried by its address), and ENrecvBatch drains the
+ * 				sockets epoll reports as readable into the node mailboxes.
+ * 				Drop, overflow and counting rules are the ones of EmulNet; the
+ * 				latency model is left to the kernel. A process that runs a single
+ * 				node (ENsolo) opens only the socket of that node and sleeps in
+ * 				epoll between ticks, so each node can be its own OS process.
+ */
+class UdpNet: public EmulNet {
+private:
+	short basePort;
+	int epfd;
+	// Timer that ends an ENwait, in the epoll set under UDP_TIMER_TAG
+	int timerfd;
+	// Socket of every node id, -1 until first used
+	vector<int> sockets;
+	// Datagrams the kernel dropped because the receive buffer of a socket was full,
+	// per node id, as last reported by SO_RXQ_OVFL
+	vector<unsigned int> rcvbufDrops;
+	// Datagrams not sent because the send buffer was full, or for any other error
+	unsigned long sendBusy;
+	unsigned long sendErrors;
+	int getSocket(int id, short port);
+	int getSocket(Address *addr);
+	void drain(int id);
+protected:
+	void transmit(en_msg *em);
+	void collect(Address *addr);
+public:
+	UdpNet(Params *p, short basePort);
+	virtual ~UdpNet();
+	void *ENinit(Address *myaddr, short port);
+	int ENmaxSize();
+	void ENwait(Address *myaddr, long long deadline);
+	int ENcleanup();
+};
+
+#endif /* _UDPNET_H_ */
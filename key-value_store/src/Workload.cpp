@@ -0,0 +1,318 @@
+/**********************************
+ * FILE NAME: Workload.cpp
+ *
+ * DESCRIPTION: Definition of the YCSB-style workload generator of the KV store
+ **********************************/
+
+#include "Workload.h"
+
+// Characters of values; keys pad their number with the letters only, so that
+// the digits of one key can never run into the padding of another
+static const char wlChars[] =
+"0123456789"
+"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+"abcdefghijklmnopqrstuvwxyz";
+#define WL_DIGITS 10
+#define WL_CHARS (sizeof(wlChars) - 1)
+
+/**
+ * Constructor
+ */
+Workload::Workload(Params *par, unsigned int seed): par(par), seed(seed), live(0), credit(0), ticks(0) {
+	memset(issued, 0, sizeof(issued));
+	zipfInit(access, 0);
+	zipfInit(keySizes, par->WL_KEY_MAX > par->WL_KEY_MIN ? par->WL_KEY_MAX - par->WL_KEY_MIN + 1 : 1);
+	zipfInit(valueSizes, par->WL_VALUE_MAX > par->WL_VALUE_MIN ? par->WL_VALUE_MAX - par->WL_VALUE_MIN + 1 : 1);
+	if ( par->WL_RECORDS > 0 ) {
+		keys.reserve(par->WL_RECORDS);
+		deleted.reserve(par->WL_RECORDS);
+	}
+}
+
+/**
+ * Destructor
+ */
+Workload::~Workload() {}
+
+/**
+ * FUNCTION NAME: random
+ *
+ * DESCRIPTION: Uniform draw from [0, 1)
+ */
+double Workload::random() {
+	return rand_r(&seed) / ((double)RAND_MAX + 1);
+}
+
+/**
+ * FUNCTION NAME: zipfInit
+ *
+ * DESCRIPTION: Set up a zipfian distribution over items ranks with skew WL_ZIPF_THETA
+ */
+void Workload::zipfInit(wl_zipf &zipf, long items) {
+	zipf.theta = par->WL_ZIPF_THETA;
+	if ( zipf.theta < 0 ) {
+		zipf.theta = 0;
+	}
+	if ( zipf.theta > 0.999 ) {
+		// alpha = 1 / (1 - theta) has no finite value at 1
+		zipf.theta = 0.999;
+	}
+	zipf.items = 0;
+	zipf.zetan = 0;
+	zipf.zeta2 = 1 + pow(0.5, zipf.theta);
+	zipf.alpha = 1 / (1 - zipf.theta);
+	zipf.eta = 0;
+	zipfGrow(zipf, items);
+}
+
+/**
+ * FUNCTION NAME: zipfGrow
+ *
+ * DESCRIPTION: Extend a zipfian distribution to items ranks; costs one term per new rank
+ */
+void Workload::zipfGrow(wl_zipf &zipf, long items) {
+	if ( items <= zipf.items ) {
+		return;
+	}
+	for ( long i = zipf.items + 1; i <= items; i++ ) {
+		zipf.zetan += 1 / pow((double)i, zipf.theta);
+	}
+	zipf.items = items;
+	if ( items > 2 ) {
+		zipf.eta = (1 - pow(2.0 / items, 1 - zipf.theta)) / (1 - zipf.zeta2 / zipf.zetan);
+	}
+}
+
+/**
+ * FUNCTION NAME: zipfNext
+ *
+ * DESCRIPTION: Draw a rank, 0 the most likely
+ */
+long Workload::zipfNext(wl_zipf &zipf) {
+	if ( zipf.items <= 1 ) {
+		return 0;
+	}
+
+	double u = random();
+	double uz = u * zipf.zetan;
+
+	if ( uz < 1 ) {
+		return 0;
+	}
+	if ( uz < zipf.zeta2 ) {
+		return 1;
+	}
+
+	long rank = (long)(zipf.items * pow(zipf.eta * u - zipf.eta + 1, zipf.alpha));
+	return rank < zipf.items ? rank : zipf.items - 1;
+}
+
+/**
+ * FUNCTION NAME: nextSize
+ *
+ * DESCRIPTION: Draw a length between min and max from WL_SIZE_DIST
+ */
+int Workload::nextSize(wl_zipf &zipf, int min, int max) {
+	if ( max <= min ) {
+		return min;
+	}
+	switch ( par->WL_SIZE_DIST ) {
+		case CONSTANT_SIZE:
+			return max;
+		case ZIPFIAN_SIZE:
+			// short ones are the common case
+			return min + zipfNext(zipf);
+		default:
+			return min + (int)(random() * (max - min + 1));
+	}
+}
+
+/**
+ * FUNCTION NAME: nextIndex
+ *
+ * DESCRIPTION: Draw the index of a key from WL_ACCESS
+ *
+ * RETURNS:
+ * -1 if there are no keys yet
+ */
+long Workload::nextIndex() {
+	long n = keys.size();
+	unsigned long hash;
+	long rank, base;
+
+	if ( n == 0 ) {
+		return -1;
+	}
+
+	switch ( par->WL_ACCESS ) {
+		case UNIFORM_ACCESS:
+			return (long)(random() * n);
+		case LATEST_ACCESS:
+			// the most recently created keys are the hottest
+			zipfGrow(access, n);
+			return n - 1 - zipfNext(access);
+		default:
+			zipfGrow(access, n);
+			rank = zipfNext(access);
+			base = n < par->WL_RECORDS ? n : par->WL_RECORDS;
+			if ( rank >= base ) {
+				// keys inserted after the load phase keep their place in line
+				return rank;
+			}
+			// scatter the popular ranks over the loaded keys (FNV-1a of the rank)
+			// so the hot keys do not all sit next to each other
+			hash = 14695981039346656037UL;
+			for ( unsigned int i = 0; i < sizeof(rank); i++ ) {
+				hash ^= (rank >> (8 * i)) & 0xff;
+				hash *= 1099511628211UL;
+			}
+			return hash % base;
+	}
+}
+
+/**
+ * FUNCTION NAME: pickKey
+ *
+ * DESCRIPTION: Draw the index of a key to operate on, redrawing a few times to
+ * 				avoid keys that were deleted
+ */
+long Workload::pickKey() {
+	long index = nextIndex();
+
+	for ( int i = 1; i < WL_RETRIES && index >= 0 && deleted[index]; i++ ) {
+		index = nextIndex();
+	}
+	return index;
+}
+
+/**
+ * FUNCTION NAME: randomString
+ *
+ * DESCRIPTION: length characters drawn from the first nchars of chars
+ */
+string Workload::randomString(int length, const char *chars, int nchars) {
+	string s;
+
+	s.reserve(length);
+	for ( int i = 0; i < length; i++ ) {
+		s.push_back(chars[(int)(random() * nchars)]);
+	}
+	return s;
+}
+
+/**
+ * FUNCTION NAME: insert
+ *
+ * DESCRIPTION: Make a create of a new key: its number, padded with letters to the drawn key length
+ */
+void Workload::insert(wl_op &op) {
+	string key = to_string(keys.size());
+	int length = nextSize(keySizes, par->WL_KEY_MIN, par->WL_KEY_MAX);
+
+	if ( length > (int)key.size() ) {
+		key += randomString(length - key.size(), wlChars + WL_DIGITS, WL_CHARS - WL_DIGITS);
+	}
+	op.type = CREATE;
+	op.key = key;
+	op.value = randomString(nextSize(valueSizes, par->WL_VALUE_MIN, par->WL_VALUE_MAX), wlChars, WL_CHARS);
+
+	keys.push_back(key);
+	deleted.push_back(0);
+	live++;
+}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Make the next operation: a create while loading, then one drawn from the mix
+ */
+void Workload::next(wl_op &op) {
+	double total = par->WL_READ + par->WL_UPDATE + par->WL_INSERT + par->WL_DELETE;
+	double r = random() * total;
+	long index;
+
+	if ( loading() || live == 0 || total <= 0 ) {
+		insert(op);
+		return;
+	}
+
+	if ( r < par->WL_INSERT ) {
+		insert(op);
+		return;
+	}
+	r -= par->WL_INSERT;
+
+	index = pickKey();
+	op.key = keys[index];
+	op.value.clear();
+	if ( r < par->WL_READ ) {
+		op.type = READ;
+	}
+	else if ( r < par->WL_READ + par->WL_UPDATE ) {
+		op.type = UPDATE;
+		op.value = randomString(nextSize(valueSizes, par->WL_VALUE_MIN, par->WL_VALUE_MAX), wlChars, WL_CHARS);
+	}
+	else {
+		op.type = DELETE;
+		if ( !deleted[index] ) {
+			deleted[index] = 1;
+			live--;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: loading
+ *
+ * DESCRIPTION: Whether the load phase still has keys to create
+ */
+bool Workload::loading() {
+	return (long)keys.size() < par->WL_RECORDS;
+}
+
+/**
+ * FUNCTION NAME: tick
+ *
+ * DESCRIPTION: Append the operations due in this tick to ops
+ */
+void Workload::tick(vector<wl_op> &ops) {
+	ticks++;
+	credit += par->WL_OPS_PER_TICK;
+	while ( credit >= 1 ) {
+		wl_op op;
+		next(op);
+		issued[op.type]++;
+		ops.push_back(op);
+		credit -= 1;
+	}
+}
+
+/**
+ * FUNCTION NAME: printStats
+ *
+ * DESCRIPTION: Print the size of the key space and the operations handed out
+ */
+void Workload::printStats(FILE *file) {
+	unsigned long total = issued[CREATE] + issued[READ] + issued[UPDATE] + issued[DELETE];
+
+	fprintf(file, "workload ticks %lu records %ld keys %lu live %ld\n", ticks, par->WL_RECORDS, (unsigned long)keys.size(), live);
+	fprintf(file, "ops create %lu read %lu update %lu delete %lu per_tick %.3f\n", issued[CREATE], issued[READ], issued[UPDATE], issued[DELETE], ticks ? (double)total / ticks : 0.0);
+}
+
+/**
+ * FUNCTION NAME: checkpoint
+ *
+ * DESCRIPTION: Save or restore the key space and the state of the generators
+ */
+void Workload::checkpoint(Checkpoint &cp) {
+	cp.io(seed);
+	cp.io(keys);
+	cp.io(deleted);
+	cp.io(live);
+	cp.io(credit);
+	cp.io(access);
+	cp.io(keySizes);
+	cp.io(valueSizes);
+	cp.io(issued);
+	cp.io(ticks);
+}
@@ -0,0 +1,98 @@
+/**********************************
+ * FILE NAME: Workload.h
+ *
+ * DESCRIPTION: Header file of the YCSB-style workload generator of the KV store
+ **********************************/
+
+#ifndef _WORKLOAD_H_
+#define _WORKLOAD_H_
+
+#include "stdincludes.h"
+#include "Params.h"
+#include "common.h"
+#include "Checkpoint.h"
+
+/*
+ * Macros
+ */
+#define WORKLOAD_LOG "workload.log"
+// Draws after which a read, update or delete settles for a deleted key
+#define WL_RETRIES 8
+
+/**
+ * Struct Name: wl_op
+ *
+ * DESCRIPTION: One operation for a coordinator to issue
+ */
+typedef struct wl_op {
+	MessageType type;
+	string key;
+	string value;
+}wl_op;
+
+/**
+ * Struct Name: wl_zipf
+ *
+ * DESCRIPTION: State of a zipfian distribution over ranks 0 .. items - 1, rank 0
+ * 				the most popular (Gray et al., "Quickly generating billion-record
+ * 				synthetic databases"). zetan is kept incrementally so the item
+ * 				count can grow as keys are inserted.
+ */
+typedef struct wl_zipf {
+	long items;
+	double theta;
+	// Sum of 1 / i^theta for i = 1 .. items, and for i = 1 .. 2
+	double zetan;
+	double zeta2;
+	double alpha;
+	double eta;
+}wl_zipf;
+
+/**
+ * CLASS NAME: Workload
+ *
+ * DESCRIPTION: Generates the operations of a YCSB-style workload from the WL_*
+ * 				parameters. The load phase creates WL_RECORDS keys, then every
+ * 				operation is drawn from the read/update/insert/delete mix and
+ * 				goes to a key picked by the uniform, zipfian or latest access
+ * 				distribution. tick() hands out WL_OPS_PER_TICK operations per
+ * 				call, carrying fractions over to the next tick.
+ */
+class Workload {
+private:
+	Params *par;
+	unsigned int seed;
+	// Keys in the order they were created, and which of them were deleted since
+	vector<string> keys;
+	vector<char> deleted;
+	long live;
+	// Operations the rate allows that were not handed out yet
+	double credit;
+	wl_zipf access;
+	wl_zipf keySizes;
+	wl_zipf valueSizes;
+	// Operations handed out per MessageType, CREATE to DELETE
+	unsigned long issued[DELETE + 1];
+	unsigned long ticks;
+	double random();
+	void zipfInit(wl_zipf &zipf, long items);
+	void zipfGrow(wl_zipf &zipf, long items);
+	long zipfNext(wl_zipf &zipf);
+	int nextSize(wl_zipf &zipf, int min, int max);
+	long nextIndex();
+	long pickKey();
+	string randomString(int length, const char *chars, int nchars);
+	void insert(wl_op &op);
+	void next(wl_op &op);
+public:
+	Workload(Params *par, unsigned int seed);
+	Workload(const Workload &anotherWorkload) = delete;
+	Workload& operator =(const Workload &anotherWorkload) = delete;
+	virtual ~Workload();
+	bool loading();
+	void tick(vector<wl_op> &ops);
+	void printStats(FILE *file);
+	void checkpoint(Checkpoint &cp);
+};
+
+#endif /* _WORKLOAD_H_ */